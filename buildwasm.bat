@@ -4,8 +4,11 @@ SET LIB_DIR=lib
 SET SRC_DIR=%LIB_DIR%\src
 
 SET SRCS=^
+	%SRC_DIR%\convolver.c ^
 	%SRC_DIR%\fft4g.c ^
 	%SRC_DIR%\fft4gf.c ^
+	%SRC_DIR%\fftThreads.c ^
+	%SRC_DIR%\fftq15.c ^
 	%SRC_DIR%\graphicalFilterEditor.c ^
 	%SRC_DIR%\plainAnalyzer.c ^
 	%SRC_DIR%\waveletAnalyzer.c
@@ -29,15 +32,26 @@ REM
 REM As of August 2020, WASM=2 does not work properly, even if loading the correct file
 REM manually during runtime... That's why I'm compiling it twice...
 
+REM
+REM The FFT kernels have SIMD versions (see lib\src\simd.h), which are only used in the
+REM WebAssembly build (asm.js has no SIMD)
+REM
+REM Multithreaded transforms are not enabled here (see FFT_THREADS in Makefile)
+
+SETLOCAL ENABLEDELAYEDEXPANSION
+
 FOR /l %%X IN (0,1,1) DO (
 	MOVE %LIB_DIR%\lib.js %LIB_DIR%\lib-nowasm.js
 
+	IF %%X==1 (SET WASM_SIMD=-msimd128) ELSE (SET WASM_SIMD=)
+
 	CALL emcc ^
 		-I%SRC_DIR% ^
 		-s WASM=%%X ^
+		!WASM_SIMD! ^
 		-s PRECISE_F32=0 ^
 		-s DYNAMIC_EXECUTION=0 ^
-		-s EXPORTED_FUNCTIONS="['_allocBuffer', '_freeBuffer', '_fftSizeOf', '_fftInit', '_fftAlloc', '_fftFree', '_fftChangeN', '_fftSizeOff', '_fftInitf', '_fftAllocf', '_fftFreef', '_fftChangeNf', '_fft', '_ffti', '_fftf', '_fftif', '_graphicalFilterEditorAlloc', '_graphicalFilterEditorGetFilterKernelBuffer', '_graphicalFilterEditorGetChannelCurve', '_graphicalFilterEditorGetActualChannelCurve', '_graphicalFilterEditorGetVisibleFrequencies', '_graphicalFilterEditorGetEquivalentZones', '_graphicalFilterEditorGetEquivalentZonesFrequencyCount', '_graphicalFilterEditorUpdateFilter', '_graphicalFilterEditorUpdateActualChannelCurve', '_graphicalFilterEditorChangeFilterLength', '_graphicalFilterEditorFree', '_plainAnalyzer', '_waveletAnalyzer']" ^
+		-s EXPORTED_FUNCTIONS="['_allocBuffer', '_freeBuffer', '_fftSizeOf', '_fftInit', '_fftAlloc', '_fftFree', '_fftChangeN', '_fftSizeOff', '_fftInitf', '_fftAllocf', '_fftFreef', '_fftChangeNf', '_fft', '_ffti', '_fftf', '_fftif', '_fftPair', '_fftPairi', '_fftPairf', '_fftPairif', '_fftPruned', '_fftPairPruned', '_fftPrunedf', '_fftPairPrunedf', '_fftPrunedBins', '_fftPrunedBinsf', '_fftScratchSizeOf', '_fftChangeEngine', '_fftScratchSizeOff', '_fftChangeEnginef', '_fftExportWisdom', '_fftImportWisdom', '_fftExportWisdomf', '_fftImportWisdomf', '_fftSetThreadCount', '_fftSizeOfq15', '_fftInitq15', '_fftAllocq15', '_fftFreeq15', '_fftPairPrunedq15', '_fftPairMagnitudesq15', '_graphicalFilterEditorArenaAlloc', '_graphicalFilterEditorArenaFree', '_graphicalFilterEditorAllocInArena', '_graphicalFilterEditorAlloc', '_graphicalFilterEditorGetFilterKernelBuffer', '_graphicalFilterEditorGetFilterKernels', '_graphicalFilterEditorGetChannelCount', '_graphicalFilterEditorGetChannelCurve', '_graphicalFilterEditorGetActualChannelCurve', '_graphicalFilterEditorGetVisibleFrequencies', '_graphicalFilterEditorGetEquivalentZones', '_graphicalFilterEditorGetEquivalentZonesFrequencyCount', '_graphicalFilterEditorUpdateFilter', '_graphicalFilterEditorUpdateFilterAndCurve', '_graphicalFilterEditorUpdateFilters', '_graphicalFilterEditorUpdateActualChannelCurve', '_graphicalFilterEditorChangeFilterLength', '_graphicalFilterEditorChangeSampleRate', '_graphicalFilterEditorChangeBasisKernelsEnabled', '_graphicalFilterEditorChangeIsSinglePrecision', '_graphicalFilterEditorFree', '_graphicalFilterEditorUpdateConvolver', '_convolverSizeOf', '_convolverAlloc', '_convolverFree', '_convolverGetBlock', '_convolverGetSegmentCount', '_convolverGetSegmentPartitionLength', '_convolverGetSegmentPartitionCount', '_convolverChangeKernel', '_convolverReset', '_convolverProcess', '_plainAnalyzer', '_waveletAnalyzer']" ^
 		-s ALLOW_MEMORY_GROWTH=0 ^
 		-s INITIAL_MEMORY=327680 ^
 		-s MAXIMUM_MEMORY=327680 ^
@@ -0,0 +1,53 @@
+# Checks that every function called through cLib by the TypeScript sources is listed in
+# EXPORTED_FUNCTIONS (both lists of Makefile, and buildwasm.bat), and that the artifacts
+# (lib/lib.js and lib/lib-nowasm.js, built by make, and assets/js/graphicalFilterEditor.min.js,
+# built by tscmin.sh) are up to date with them. Run it before committing the artifacts.
+
+status=0
+
+exports() {
+	grep -o "EXPORTED_FUNCTIONS=[^]]*]" $1 | sed -n "$2p" | sed "s/^EXPORTED_FUNCTIONS=//" | grep -o "_[A-Za-z0-9_]*" | sort -u
+}
+
+exports Makefile 1 > /tmp/checkexports.makefile1
+exports Makefile 2 > /tmp/checkexports.makefile2
+exports buildwasm.bat 1 > /tmp/checkexports.bat
+grep -rhoE "cLib\._[A-Za-z0-9_]+" scripts --include=*.ts | sed "s/cLib\.//" | sort -u > /tmp/checkexports.used
+
+for list in makefile2 bat; do
+	if ! cmp -s /tmp/checkexports.makefile1 /tmp/checkexports.$list; then
+		echo "EXPORTED_FUNCTIONS differs ($list):"
+		diff /tmp/checkexports.makefile1 /tmp/checkexports.$list
+		status=1
+	fi
+done
+
+for name in $(comm -23 /tmp/checkexports.used /tmp/checkexports.makefile1); do
+	echo "Not exported: $name"
+	status=1
+done
+
+for artifact in lib/lib.js lib/lib-nowasm.js; do
+	for name in $(cat /tmp/checkexports.makefile1); do
+		if ! grep -qw "$name" $artifact; then
+			echo "Missing from $artifact: $name"
+			status=1
+		fi
+	done
+done
+
+for name in $(cat /tmp/checkexports.used); do
+	if ! grep -qw "$name" assets/js/graphicalFilterEditor.min.js; then
+		echo "Missing from assets/js/graphicalFilterEditor.min.js: $name"
+		status=1
+	fi
+done
+
+rm /tmp/checkexports.makefile1 /tmp/checkexports.makefile2 /tmp/checkexports.bat /tmp/checkexports.used
+
+if [ $status -ne 0 ]; then
+	echo "FAILED"
+else
+	echo "OK"
+fi
+exit $status
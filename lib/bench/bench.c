@@ -0,0 +1,652 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+// FFT micro-benchmark and accuracy suite
+//
+// Native (Linux): make bench && lib/bench/bench
+// WebAssembly (Node.js): make bench-wasm && node lib/bench/bench.js
+//
+// For every power of 2 from 8 to MaximumFFTLength, and for a few other lengths (which
+// use the mixed-radix plans, see fftMixedInit() in fft4g.c), and for both precisions,
+// reports the time taken by fft()/ffti() and fftf()/fftif() (in ns per transform, and
+// in pseudo-GFLOPS, computed as 2.5 * n * log2(n) / time, the usual convention for real
+// transforms), along with their maximum and RMS errors against a naive DFT computed
+// with long double (both relative to the RMS of the reference). Above
+// BenchFullDFTMaximumN, only BenchCheckedCount bins/samples, spread over the output,
+// are checked (marked with * in the report).
+//
+// Then, for the same lengths, reports the maximum errors of the other entry points
+// against the same reference: fftPair()/fftPairi(), fftPruned(), fftPairPruned(),
+// fftPrunedBins() (with BenchFewBins bins, and with all of them) and, for the lengths
+// it supports, fftPairPrunedq15() followed by fftPairMagnitudesq15(). The areas the
+// pruned transforms promise not to read are filled with BenchSentinel beforehand. The
+// suite exits with 1 when the errors of fftPrunedBins() are above BenchMaximumBinsError
+// (double) or BenchMaximumBinsErrorf (float).
+//
+// Options:
+// -stockham: use FFTEngineStockham (FFTEngineOoura is used by default)
+// -auto: use FFTEngineAuto
+// -threads N: split large transforms among N threads (see fftSetThreadCount())
+// -max N: largest n (a power of 2)
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#include <math.h>
+#include "fft4g.h"
+
+#define BenchFullDFTMaximumN 4096
+#define BenchCheckedCount 64
+// Every trial lasts at least BenchTrialMs, and the fastest of BenchTrials is kept
+#define BenchTrialMs 10.0
+#define BenchTrials 5
+// Bins requested from fftPrunedBins() in the first test (few enough for the Goertzel
+// bank to be used, when n is a power of 2)
+#define BenchFewBins 4
+#define BenchSentinel 1e30
+// Largest errors accepted from fftPrunedBins() (with either number of bins), above which
+// the suite fails (the Goertzel bank must be as accurate as the transform it replaces)
+#define BenchMaximumBinsError 1e-13
+#define BenchMaximumBinsErrorf 1e-5
+// Lengths supported by fftPairPrunedq15() (see fftq15.c)
+#define BenchQ15MinimumN 16
+#define BenchQ15MaximumN 65536
+
+#define BenchPI 3.1415926535897932384626433832795L
+
+// Lengths other than powers of 2 (odd, even, prime, and multiples of 44100/48000)
+static const int benchOtherLengths[] = { 12, 15, 17, 45, 100, 441, 1000, 1021, 1323, 2205, 4410, 6000, 11025, 44100 };
+
+typedef struct BenchReferenceStruct {
+	int n, checkedCount, sampleCount;
+	// Indices of the checked bins (forward) and samples (inverse)
+	int* bins;
+	int* samples;
+	// Inputs of the forward transforms (x and y are random, while xPruned and yPruned
+	// are their first n / 2 samples, followed by zeroes), and the expected bins (re, im)
+	long double* x;
+	long double* y;
+	long double* bin;
+	long double* yBin;
+	long double* xPrunedBin;
+	long double* yPrunedBin;
+	// Inputs of the inverse transforms (ordered as described in fft4g.h), and the
+	// expected samples
+	long double* spectrum;
+	long double* ySpectrum;
+	long double* sample;
+	long double* ySample;
+	// cos/sin(2.pi.k/n)
+	long double* c;
+	long double* s;
+} BenchReference;
+
+typedef struct BenchResultStruct {
+	double fftNs, fftiNs, fftMaxError, fftRmsError, fftiMaxError, fftiRmsError;
+} BenchResult;
+
+// Maximum errors of the other entry points (negative when not applicable)
+typedef struct BenchEntryResultStruct {
+	double pair, pairi, pruned, pairPruned, fewBins, allBins;
+} BenchEntryResult;
+
+static unsigned int benchSeed;
+
+static long double benchRandom(void) {
+	// Uniform in [-1, 1)
+	benchSeed = (benchSeed * 1664525) + 1013904223;
+	return ((long double)(benchSeed >> 8) / (long double)(1 << 23)) - 1.0L;
+}
+
+static void benchChooseIndices(int* indices, int count, int range) {
+	// Always include both ends, then spread the others evenly (with a small jitter)
+	indices[0] = 0;
+	indices[count - 1] = range - 1;
+	for (int i = 1; i < count - 1; i++)
+		indices[i] = (int)(((long long)i * range) / count) + (int)((benchSeed = (benchSeed * 1664525) + 1013904223) % (unsigned int)(range / count));
+}
+
+// Position of the real part of bin k, according to the ordering described in fft4g.h
+// (the imaginary part follows it, except for bin 0 and bin n / 2, which are real)
+static int benchBinPosition(int n, int k) {
+	if (!k)
+		return 0;
+	if (!(n & 1) && k == (n >> 1))
+		return 1;
+	return ((n & 1) ? ((k << 1) - 1) : (k << 1));
+}
+
+// X[k] = sum(x[j] . e^(i.2.pi.j.k/n)), the same convention used by rdft(), for the
+// checked bins (only the first length samples of x are used)
+static void benchDFT(const BenchReference* ref, const long double* x, int length, long double* bin) {
+	const int n = ref->n;
+	for (int i = 0; i < ref->checkedCount; i++) {
+		const int k = ref->bins[i];
+		long double re = 0, im = 0;
+		for (int j = 0, jk = 0; j < length; j++) {
+			re += x[j] * ref->c[jk];
+			im += x[j] * ref->s[jk];
+			jk += k;
+			if (jk >= n)
+				jk -= n;
+		}
+		bin[(i << 1)] = re;
+		bin[(i << 1) + 1] = im;
+	}
+}
+
+// x[j] = (X[0] + (-1)^j.X[n/2] + 2.sum(Re(X[k] . e^(-i.2.pi.j.k/n)))) / n, which
+// is exactly what ffti() computes (as ffti(fft(x)) = x), for the checked samples
+// (there is no X[n/2] when n is odd)
+static void benchIDFT(const BenchReference* ref, const long double* spectrum, long double* sample) {
+	const int n = ref->n, binCount = (n + 1) >> 1;
+	for (int i = 0; i < ref->sampleCount; i++) {
+		const int j = ref->samples[i];
+		long double sum = 0;
+		for (int k = 1, jk = j; k < binCount; k++) {
+			const int p = benchBinPosition(n, k);
+			sum += (spectrum[p] * ref->c[jk]) + (spectrum[p + 1] * ref->s[jk]);
+			jk += j;
+			if (jk >= n)
+				jk -= n;
+		}
+		long double nyquist = 0;
+		if (!(n & 1))
+			nyquist = ((j & 1) ? -spectrum[1] : spectrum[1]);
+		sample[i] = (spectrum[0] + nyquist + (2.0L * sum)) / (long double)n;
+	}
+}
+
+static int benchPrepareReference(BenchReference* ref, int n) {
+	const int h = n >> 1, full = (n <= BenchFullDFTMaximumN);
+	ref->n = n;
+	ref->checkedCount = (full ? (h + 1) : BenchCheckedCount);
+	ref->sampleCount = (full ? n : BenchCheckedCount);
+	ref->bins = (int*)malloc(sizeof(int) * ref->checkedCount);
+	ref->samples = (int*)malloc(sizeof(int) * ref->sampleCount);
+	ref->x = (long double*)malloc(sizeof(long double) * n);
+	ref->y = (long double*)malloc(sizeof(long double) * n);
+	ref->bin = (long double*)malloc(sizeof(long double) * 2 * ref->checkedCount);
+	ref->yBin = (long double*)malloc(sizeof(long double) * 2 * ref->checkedCount);
+	ref->xPrunedBin = (long double*)malloc(sizeof(long double) * 2 * ref->checkedCount);
+	ref->yPrunedBin = (long double*)malloc(sizeof(long double) * 2 * ref->checkedCount);
+	ref->spectrum = (long double*)malloc(sizeof(long double) * n);
+	ref->ySpectrum = (long double*)malloc(sizeof(long double) * n);
+	ref->sample = (long double*)malloc(sizeof(long double) * ref->sampleCount);
+	ref->ySample = (long double*)malloc(sizeof(long double) * ref->sampleCount);
+	ref->c = (long double*)malloc(sizeof(long double) * n);
+	ref->s = (long double*)malloc(sizeof(long double) * n);
+	if (!ref->bins || !ref->samples || !ref->x || !ref->y || !ref->bin || !ref->yBin || !ref->xPrunedBin || !ref->yPrunedBin ||
+		!ref->spectrum || !ref->ySpectrum || !ref->sample || !ref->ySample || !ref->c || !ref->s)
+		return 0;
+
+	benchSeed = (unsigned int)n;
+	for (int j = 0; j < n; j++) {
+		ref->x[j] = benchRandom();
+		ref->y[j] = benchRandom();
+		ref->spectrum[j] = benchRandom();
+		ref->ySpectrum[j] = benchRandom();
+		ref->c[j] = cosl((2.0L * BenchPI * (long double)j) / (long double)n);
+		ref->s[j] = sinl((2.0L * BenchPI * (long double)j) / (long double)n);
+	}
+
+	if (full) {
+		for (int k = 0; k <= h; k++)
+			ref->bins[k] = k;
+		for (int j = 0; j < n; j++)
+			ref->samples[j] = j;
+	} else {
+		benchChooseIndices(ref->bins, BenchCheckedCount, h + 1);
+		// The first bins are always checked, as fftPrunedBins() may compute only them
+		for (int k = 1; k < BenchFewBins; k++)
+			ref->bins[k] = k;
+		benchChooseIndices(ref->samples, BenchCheckedCount, n);
+	}
+
+	benchDFT(ref, ref->x, n, ref->bin);
+	benchDFT(ref, ref->y, n, ref->yBin);
+	benchDFT(ref, ref->x, h, ref->xPrunedBin);
+	benchDFT(ref, ref->y, h, ref->yPrunedBin);
+	benchIDFT(ref, ref->spectrum, ref->sample);
+	benchIDFT(ref, ref->ySpectrum, ref->ySample);
+	return 1;
+}
+
+static void benchFreeReference(BenchReference* ref) {
+	free(ref->bins);
+	free(ref->samples);
+	free(ref->x);
+	free(ref->y);
+	free(ref->bin);
+	free(ref->yBin);
+	free(ref->xPrunedBin);
+	free(ref->yPrunedBin);
+	free(ref->spectrum);
+	free(ref->ySpectrum);
+	free(ref->sample);
+	free(ref->ySample);
+	free(ref->c);
+	free(ref->s);
+}
+
+// Errors of a forward transform (output ordered as described in fft4g.h), relative
+// to the RMS of the reference (bin), considering only the checked bins below binCount
+static void benchForwardError(const BenchReference* ref, const long double* output, const long double* bin, int binCount, double* maxError, double* rmsError) {
+	const int n = ref->n;
+	long double maxE = 0, sumE = 0, sumR = 0;
+	int count = 0;
+	for (int i = 0; i < ref->checkedCount; i++) {
+		const int k = ref->bins[i];
+		if (k >= binCount)
+			continue;
+		const int p = benchBinPosition(n, k);
+		// Bin 0 and bin n / 2 (at positions 0 and 1, when n is even) are real
+		const long double re = output[p], im = ((p > ((n & 1) ? 0 : 1)) ? output[p + 1] : 0);
+		const long double er = re - bin[(i << 1)], ei = im - bin[(i << 1) + 1];
+		const long double e = sqrtl((er * er) + (ei * ei));
+		if (maxE < e)
+			maxE = e;
+		sumE += e * e;
+		sumR += (bin[(i << 1)] * bin[(i << 1)]) + (bin[(i << 1) + 1] * bin[(i << 1) + 1]);
+		count++;
+	}
+	const long double rmsR = sqrtl(sumR / (long double)count);
+	*maxError = (double)(maxE / rmsR);
+	*rmsError = (double)(sqrtl(sumE / (long double)count) / rmsR);
+}
+
+static void benchInverseError(const BenchReference* ref, const long double* output, const long double* sample, double* maxError, double* rmsError) {
+	long double maxE = 0, sumE = 0, sumR = 0;
+	for (int i = 0; i < ref->sampleCount; i++) {
+		const long double e = fabsl(output[ref->samples[i]] - sample[i]);
+		if (maxE < e)
+			maxE = e;
+		sumE += e * e;
+		sumR += sample[i] * sample[i];
+	}
+	const long double rmsR = sqrtl(sumR / (long double)ref->sampleCount);
+	*maxError = (double)(maxE / rmsR);
+	*rmsError = (double)(sqrtl(sumE / (long double)ref->sampleCount) / rmsR);
+}
+
+static double benchMax(double a, double b) {
+	return ((a > b) ? a : b);
+}
+
+// Both precisions share the same code, which is generated by the macro below, where
+// T is the type, F is the suffix of the functions and S is the structure
+#define BENCH_PRECISION(T, F, S) \
+static double benchTime##F(S* fft4g, void (*transform)(S*, T*), const T* input, T* work, int n) { \
+	/* The input is copied before every transform (so that data never overflows), \
+	and the time taken by the copies alone is subtracted afterwards */ \
+	int repetitions = 1; \
+	for (;;) { \
+		const double start = emscripten_get_now(); \
+		for (int r = 0; r < repetitions; r++) { \
+			memcpy(work, input, sizeof(T) * n); \
+			transform(fft4g, work); \
+		} \
+		if ((emscripten_get_now() - start) >= BenchTrialMs) \
+			break; \
+		repetitions <<= 1; \
+	} \
+	double bestTime = 0, bestCopyTime = 0; \
+	for (int t = 0; t < BenchTrials; t++) { \
+		double start = emscripten_get_now(); \
+		for (int r = 0; r < repetitions; r++) { \
+			memcpy(work, input, sizeof(T) * n); \
+			transform(fft4g, work); \
+		} \
+		const double time = emscripten_get_now() - start; \
+		start = emscripten_get_now(); \
+		for (int r = 0; r < repetitions; r++) { \
+			memcpy(work, input, sizeof(T) * n); \
+			/* Keeps the compiler from discarding the copies */ \
+			work[r % n] += (T)1; \
+		} \
+		const double copyTime = emscripten_get_now() - start; \
+		if (!t || time < bestTime) \
+			bestTime = time; \
+		if (!t || copyTime < bestCopyTime) \
+			bestCopyTime = copyTime; \
+	} \
+	const double ns = ((bestTime - bestCopyTime) * 1000000.0) / (double)repetitions; \
+	return ((ns > 0) ? ns : 0); \
+} \
+\
+static int benchRun##F(const BenchReference* ref, int engine, T* scratch, BenchResult* result) { \
+	const int n = ref->n; \
+	S* const fft4g = fftAlloc##F(n); \
+	T* const input = (T*)malloc(sizeof(T) * n); \
+	T* const work = (T*)malloc(sizeof(T) * n); \
+	long double* const output = (long double*)malloc(sizeof(long double) * n); \
+	int ok = (fft4g && input && work && output && fftChangeEngine##F(fft4g, engine, scratch)); \
+	if (ok) { \
+		for (int i = 0; i < n; i++) \
+			input[i] = (T)ref->x[i]; \
+		memcpy(work, input, sizeof(T) * n); \
+		fft##F(fft4g, work); \
+		for (int i = 0; i < n; i++) \
+			output[i] = (long double)work[i]; \
+		benchForwardError(ref, output, ref->bin, n, &result->fftMaxError, &result->fftRmsError); \
+		result->fftNs = benchTime##F(fft4g, fft##F, input, work, n); \
+\
+		for (int i = 0; i < n; i++) \
+			input[i] = (T)ref->spectrum[i]; \
+		memcpy(work, input, sizeof(T) * n); \
+		ffti##F(fft4g, work); \
+		for (int i = 0; i < n; i++) \
+			output[i] = (long double)work[i]; \
+		benchInverseError(ref, output, ref->sample, &result->fftiMaxError, &result->fftiRmsError); \
+		result->fftiNs = benchTime##F(fft4g, ffti##F, input, work, n); \
+	} \
+	fftFree##F(fft4g); \
+	free(input); \
+	free(work); \
+	free(output); \
+	return ok; \
+} \
+\
+/* Fills the first n samples of x (and y, unless it is null) with the reference, \
+leaving data [limit...2n-1] with BenchSentinel, along with the rest of the samples \
+(pair is the stride, 1 for a single signal, or 2 for interleaved signals) */ \
+static void benchFill##F(const BenchReference* ref, T* data, int pair, int length, int limit) { \
+	const int n = ref->n; \
+	for (int i = 0; i < (n << 1); i++) \
+		data[i] = (T)BenchSentinel; \
+	for (int i = 0; i < length; i++) { \
+		data[i * pair] = (T)ref->x[i]; \
+		if (pair > 1) \
+			data[(i * pair) + 1] = (T)ref->y[i]; \
+	} \
+	for (int i = limit; i < (n << 1); i++) \
+		data[i] = (T)BenchSentinel; \
+} \
+\
+static double benchForwardMax##F(const BenchReference* ref, const T* data, const long double* bin, int binCount, long double* output) { \
+	double maxError, rmsError; \
+	for (int i = 0; i < ref->n; i++) \
+		output[i] = (long double)data[i]; \
+	benchForwardError(ref, output, bin, binCount, &maxError, &rmsError); \
+	return maxError; \
+} \
+\
+static int benchCheckEntries##F(const BenchReference* ref, int engine, T* scratch, BenchEntryResult* result) { \
+	const int n = ref->n, h = n >> 1; \
+	S* const fft4g = fftAlloc##F(n); \
+	T* const work = (T*)malloc(sizeof(T) * 2 * n); \
+	long double* const output = (long double*)malloc(sizeof(long double) * n); \
+	int ok = (fft4g && work && output && fftChangeEngine##F(fft4g, engine, scratch)); \
+	if (ok) { \
+		double maxError, rmsError; \
+\
+		benchFill##F(ref, work, 2, n, n << 1); \
+		fftPair##F(fft4g, work); \
+		result->pair = benchMax(benchForwardMax##F(ref, work, ref->bin, n, output), benchForwardMax##F(ref, work + n, ref->yBin, n, output)); \
+\
+		for (int i = 0; i < n; i++) { \
+			work[i] = (T)ref->spectrum[i]; \
+			work[n + i] = (T)ref->ySpectrum[i]; \
+		} \
+		fftPairi##F(fft4g, work); \
+		for (int i = 0; i < n; i++) \
+			output[i] = (long double)work[i << 1]; \
+		benchInverseError(ref, output, ref->sample, &result->pairi, &rmsError); \
+		for (int i = 0; i < n; i++) \
+			output[i] = (long double)work[(i << 1) + 1]; \
+		benchInverseError(ref, output, ref->ySample, &maxError, &rmsError); \
+		result->pairi = benchMax(result->pairi, maxError); \
+\
+		/* data [n/2...n-1] is never read */ \
+		benchFill##F(ref, work, 1, h, h); \
+		fftPruned##F(fft4g, work); \
+		result->pruned = benchForwardMax##F(ref, work, ref->xPrunedBin, n, output); \
+\
+		/* x [n/2...n-1] and y [n/2...n-1] are never read */ \
+		benchFill##F(ref, work, 2, h, h << 1); \
+		fftPairPruned##F(fft4g, work); \
+		result->pairPruned = benchMax(benchForwardMax##F(ref, work, ref->xPrunedBin, n, output), benchForwardMax##F(ref, work + n, ref->yPrunedBin, n, output)); \
+\
+		benchFill##F(ref, work, 1, h, h); \
+		fftPrunedBins##F(fft4g, work, BenchFewBins); \
+		result->fewBins = benchForwardMax##F(ref, work, ref->xPrunedBin, BenchFewBins, output); \
+\
+		benchFill##F(ref, work, 1, h, h); \
+		fftPrunedBins##F(fft4g, work, h + 1); \
+		result->allBins = benchForwardMax##F(ref, work, ref->xPrunedBin, h + 1, output); \
+	} \
+	fftFree##F(fft4g); \
+	free(work); \
+	free(output); \
+	return ok; \
+}
+
+BENCH_PRECISION(double, , FFT4g)
+BENCH_PRECISION(float, f, FFT4gf)
+
+// Maximum error of the magnitudes computed by fftPairMagnitudesq15() (of both x and y,
+// quantized to Q15, after fftPairPrunedq15()), or -1 when n is not supported
+static double benchCheckq15(const BenchReference* ref, int* ok) {
+	const int n = ref->n, h = n >> 1;
+	*ok = 1;
+	if (n < BenchQ15MinimumN || n > BenchQ15MaximumN || (n & (n - 1)))
+		return -1;
+
+	FFTQ15* const fftq15 = fftAllocq15(n);
+	short* const data = (short*)malloc(sizeof(short) * 2 * n);
+	float* const x = (float*)malloc(sizeof(float) * (h + 1));
+	float* const y = (float*)malloc(sizeof(float) * (h + 1));
+	long double* const xq = (long double*)malloc(sizeof(long double) * n);
+	long double* const yq = (long double*)malloc(sizeof(long double) * n);
+	long double* const xBin = (long double*)malloc(sizeof(long double) * 2 * ref->checkedCount);
+	long double* const yBin = (long double*)malloc(sizeof(long double) * 2 * ref->checkedCount);
+	double maxError = -1;
+	*ok = (fftq15 && data && x && y && xq && yq && xBin && yBin);
+	if (*ok) {
+		// The reference is computed from the quantized samples, so that only the errors
+		// of the transform itself are measured
+		for (int i = 0; i < (n << 1); i++)
+			data[i] = 32767;
+		for (int i = 0; i < h; i++) {
+			data[(i << 1)] = (short)lrintl(ref->x[i] * 32767.0L);
+			data[(i << 1) + 1] = (short)lrintl(ref->y[i] * 32767.0L);
+			xq[i] = (long double)data[(i << 1)];
+			yq[i] = (long double)data[(i << 1) + 1];
+		}
+		benchDFT(ref, xq, h, xBin);
+		benchDFT(ref, yq, h, yBin);
+
+		const int exponent = fftPairPrunedq15(fftq15, data);
+		fftPairMagnitudesq15(fftq15, data, exponent, x, y, h + 1);
+
+		long double maxE = 0, sumR = 0;
+		for (int i = 0; i < ref->checkedCount; i++) {
+			const int k = ref->bins[i];
+			const long double xm = sqrtl((xBin[(i << 1)] * xBin[(i << 1)]) + (xBin[(i << 1) + 1] * xBin[(i << 1) + 1]));
+			const long double ym = sqrtl((yBin[(i << 1)] * yBin[(i << 1)]) + (yBin[(i << 1) + 1] * yBin[(i << 1) + 1]));
+			const long double ex = fabsl((long double)x[k] - xm), ey = fabsl((long double)y[k] - ym);
+			if (maxE < ex)
+				maxE = ex;
+			if (maxE < ey)
+				maxE = ey;
+			sumR += (xm * xm) + (ym * ym);
+		}
+		maxError = (double)(maxE / sqrtl(sumR / (long double)(ref->checkedCount << 1)));
+	}
+	fftFreeq15(fftq15);
+	free(data);
+	free(x);
+	free(y);
+	free(xq);
+	free(yq);
+	free(xBin);
+	free(yBin);
+	return maxError;
+}
+
+static void benchPrint(const char* precision, int n, int sampled, const BenchResult* result) {
+	// Pseudo-GFLOPS = 2.5 * n * log2(n) / ns
+	const double flops = 2.5 * (double)n * log2((double)n);
+	printf("%-6s %7d %11.1f %7.3f %11.1f %7.3f %9.2e %9.2e %9.2e %9.2e%s\n",
+		precision, n,
+		result->fftNs, (result->fftNs > 0) ? (flops / result->fftNs) : 0.0,
+		result->fftiNs, (result->fftiNs > 0) ? (flops / result->fftiNs) : 0.0,
+		result->fftMaxError, result->fftRmsError, result->fftiMaxError, result->fftiRmsError,
+		sampled ? " *" : "");
+}
+
+static void benchPrintError(double error) {
+	if (error < 0)
+		printf(" %9s", "-");
+	else
+		printf(" %9.2e", error);
+}
+
+// Returns 0 (and marks the line) when fftPrunedBins() is not accurate enough
+static int benchPrintEntries(const char* precision, int n, int sampled, const BenchEntryResult* result, double maximumBinsError) {
+	const int ok = (result->fewBins <= maximumBinsError && result->allBins <= maximumBinsError);
+	printf("%-6s %7d", precision, n);
+	benchPrintError(result->pair);
+	benchPrintError(result->pairi);
+	benchPrintError(result->pruned);
+	benchPrintError(result->pairPruned);
+	benchPrintError(result->fewBins);
+	benchPrintError(result->allBins);
+	printf("%s%s\n", sampled ? " *" : "", ok ? "" : " FAILED");
+	return ok;
+}
+
+// Lengths tested: every power of 2 from 8 to maximumN, followed by benchOtherLengths
+// (up to maximumN), or 0 when index goes past the last one
+static int benchLength(int index, int maximumN) {
+	int n = 8;
+	for (; n <= maximumN && index; n <<= 1)
+		index--;
+	if (n <= maximumN)
+		return n;
+	for (int i = 0; i < (int)(sizeof(benchOtherLengths) / sizeof(int)); i++) {
+		if (benchOtherLengths[i] <= maximumN && !(index--))
+			return benchOtherLengths[i];
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int engine = FFTEngineOoura, threadCount = 1, maximumN = MaximumFFTLength;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-stockham")) {
+			engine = FFTEngineStockham;
+		} else if (!strcmp(argv[i], "-auto")) {
+			engine = FFTEngineAuto;
+		} else if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+			threadCount = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-max") && i + 1 < argc) {
+			maximumN = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [-stockham | -auto] [-threads N] [-max N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (maximumN < 8 || maximumN > MaximumFFTLength || (maximumN & (maximumN - 1))) {
+		fprintf(stderr, "-max must be a power of 2 between 8 and %d\n", MaximumFFTLength);
+		return 1;
+	}
+	threadCount = fftSetThreadCount(threadCount);
+
+	// The work area is also given to FFTEngineOoura, which only uses it for the
+	// multithreaded transforms
+	double* const scratch = (double*)malloc(fftScratchSizeOf(maximumN));
+	float* const scratchf = (float*)malloc(fftScratchSizeOff(maximumN));
+	if (!scratch || !scratchf) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+#ifdef __EMSCRIPTEN__
+	printf("Build: WebAssembly");
+#else
+	printf("Build: native");
+#endif
+#ifdef FFT_SIMD
+	printf(" (SIMD)");
+#endif
+	printf(" | Engine: %s | Threads: %d\n", ((engine == FFTEngineOoura) ? "Ooura" : ((engine == FFTEngineStockham) ? "Stockham" : "Auto")), threadCount);
+	printf("Errors are relative to the RMS of the long double DFT (* = %d bins/samples checked)\n\n", BenchCheckedCount);
+	printf("%-6s %7s %11s %7s %11s %7s %9s %9s %9s %9s\n", "", "n", "fft ns", "GFLOPS", "ffti ns", "GFLOPS", "fft max", "fft rms", "ffti max", "ffti rms");
+
+	int n;
+	for (int index = 0; (n = benchLength(index, maximumN)); index++) {
+		BenchReference ref;
+		BenchResult result, resultf;
+		if (!benchPrepareReference(&ref, n) ||
+			!benchRun(&ref, engine, scratch, &result) ||
+			!benchRunf(&ref, engine, scratchf, &resultf)) {
+			fprintf(stderr, "Out of memory (n = %d)\n", n);
+			return 1;
+		}
+		benchPrint("double", n, n > BenchFullDFTMaximumN, &result);
+		benchPrint("float", n, n > BenchFullDFTMaximumN, &resultf);
+		fflush(stdout);
+		benchFreeReference(&ref);
+	}
+
+	printf("\nMaximum errors of the other entry points (bins = fftPrunedBins() with %d bins / all bins)\n\n", BenchFewBins);
+	printf("%-6s %7s %9s %9s %9s %9s %9s %9s\n", "", "n", "pair", "pairi", "pruned", "pairPrun", "bins", "allBins");
+
+	int failed = 0;
+	for (int index = 0; (n = benchLength(index, maximumN)); index++) {
+		BenchReference ref;
+		BenchEntryResult result, resultf, resultq15 = { -1, -1, -1, -1, -1, -1 };
+		int ok;
+		if (!benchPrepareReference(&ref, n) ||
+			!benchCheckEntries(&ref, engine, scratch, &result) ||
+			!benchCheckEntriesf(&ref, engine, scratchf, &resultf) ||
+			((resultq15.pairPruned = benchCheckq15(&ref, &ok)), !ok)) {
+			fprintf(stderr, "Out of memory (n = %d)\n", n);
+			return 1;
+		}
+		if (!benchPrintEntries("double", n, n > BenchFullDFTMaximumN, &result, BenchMaximumBinsError))
+			failed = 1;
+		if (!benchPrintEntries("float", n, n > BenchFullDFTMaximumN, &resultf, BenchMaximumBinsErrorf))
+			failed = 1;
+		// fftPrunedBinsq15() does not exist (fewBins and allBins are always -1)
+		if (resultq15.pairPruned >= 0)
+			benchPrintEntries("q15", n, n > BenchFullDFTMaximumN, &resultq15, 0);
+		fflush(stdout);
+		benchFreeReference(&ref);
+	}
+
+	fftSetThreadCount(1);
+	free(scratch);
+	free(scratchf);
+	if (failed)
+		printf("\nFAILED: fftPrunedBins() is not accurate enough\n");
+	return failed;
+}
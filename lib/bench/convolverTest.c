@@ -0,0 +1,204 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+// Convolver accuracy test
+//
+// Native (Linux): make convolver-test && lib/bench/convolverTest
+//
+// Compares the output of convolverProcess() against a direct convolution computed with
+// double, for the plans chosen by planSegments() and for a few other plans, forced
+// through ConvolverPlanSegments (see convolver.c), so that segments with every number of
+// steps are exercised regardless of what the planner would choose. Every channel gets a
+// kernel of a different length (so some of them do not fill all the partitions), and
+// every case is run twice, with a call to convolverReset() in between, which must leave
+// the convolver as if it had just been allocated.
+//
+// Reports the maximum error of each case, relative to the largest output sample, and
+// exits with 1 if any of them is above TestMaximumError.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static int testPlanSegments(int blockSize, int maximumKernelLength, int* partitionLengths, int* partitionCounts);
+#define ConvolverPlanSegments testPlanSegments
+#include "convolver.c"
+
+#define TestMaximumKernelLength 10000
+#define TestMaximumError 1e-5
+
+// { blockSize, partitionLength of the other segments..., 0 }, or { blockSize, -1 } for
+// the plan chosen by planSegments()
+static const int testPlans[][ConvolverMaximumSegmentCount + 1] = {
+	{ 128, -1 },
+	{ 1024, -1 },
+	{ 128, 0 },
+	{ 128, 256, 0 },
+	{ 128, 256, 512, 0 },
+	{ 128, 256, 1024, 4096, 0 },
+	{ 128, 512, 2048, 0 },
+	{ 128, 256, 512, 1024, 2048, 0 },
+	{ 256, 512, 4096, 0 },
+	{ 1024, 2048, 0 }
+};
+static const int testChannelCounts[] = { 1, 2, 3, 8 };
+
+static const int* testPlan;
+
+static int testPlanSegments(int blockSize, int maximumKernelLength, int* partitionLengths, int* partitionCounts) {
+	if (testPlan[1] < 0)
+		return planSegments(blockSize, maximumKernelLength, partitionLengths, partitionCounts);
+
+	// The partitions are counted just like planSegments() does
+	int count = 1;
+	partitionLengths[0] = blockSize;
+	while (testPlan[count])
+		partitionLengths[count] = testPlan[count], count++;
+	for (int s = 0; s < count; s++) {
+		const int offset = (s ? ((partitionLengths[s] << 1) - blockSize) : 0);
+		partitionCounts[s] = (((s + 1) < count) ? (((partitionLengths[s + 1] << 1) - blockSize - offset) / partitionLengths[s]) :
+			((maximumKernelLength - offset + partitionLengths[s] - 1) / partitionLengths[s]));
+	}
+	return count;
+}
+
+static float testRandom(void) {
+	return ((float)rand() / (float)RAND_MAX) - 0.5f;
+}
+
+// Feeds sampleCount samples of each channel (sampleCount is a multiple of blockSize) and
+// returns the maximum error of the output against input * kernel, relative to the largest
+// output sample
+static double testRun(Convolver* convolver, const float* kernels, const int* kernelLengths, float* input, float* output, double* expected, int sampleCount) {
+	const int blockSize = convolver->blockSize, channelCount = convolver->channelCount;
+
+	for (int i = 0; i < channelCount * sampleCount; i++)
+		input[i] = testRandom();
+
+	for (int position = 0; position < sampleCount; position += blockSize) {
+		for (int ch = 0; ch < channelCount; ch++)
+			memcpy(convolverGetBlock(convolver, ch), input + (ch * sampleCount) + position, sizeof(float) * blockSize);
+		convolverProcess(convolver);
+		for (int ch = 0; ch < channelCount; ch++)
+			memcpy(output + (ch * sampleCount) + position, convolverGetBlock(convolver, ch), sizeof(float) * blockSize);
+	}
+
+	// Each block is replaced by its own output (the latency comes from gathering the block).
+	// The direct convolution adds one tap at a time to all samples, which is a lot faster
+	// than computing one sample at a time.
+	double maximumError = 0.0, maximumOutput = 0.0;
+	for (int ch = 0; ch < channelCount; ch++) {
+		const float* const x = input + (ch * sampleCount);
+		const float* const h = kernels + (ch * TestMaximumKernelLength);
+		const float* const y = output + (ch * sampleCount);
+		for (int n = 0; n < sampleCount; n++)
+			expected[n] = 0.0;
+		for (int k = 0; k < kernelLengths[ch]; k++) {
+			const double tap = (double)h[k];
+			double* const e = expected + k;
+			for (int n = sampleCount - k - 1; n >= 0; n--)
+				e[n] += tap * (double)x[n];
+		}
+		for (int n = 0; n < sampleCount; n++) {
+			const double error = fabs(expected[n] - (double)y[n]);
+			if (maximumError < error)
+				maximumError = error;
+			if (maximumOutput < fabs(expected[n]))
+				maximumOutput = fabs(expected[n]);
+		}
+	}
+	return maximumError / maximumOutput;
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	float* const kernels = (float*)malloc(sizeof(float) * MaximumChannelCount * TestMaximumKernelLength);
+	int kernelLengths[MaximumChannelCount];
+	int failed = 0;
+
+	srand(1);
+
+	printf("block  channels  plan (partitionLength x partitionCount)  error 1  error 2\n");
+
+	for (size_t p = 0; p < (sizeof(testPlans) / sizeof(testPlans[0])); p++) {
+		testPlan = testPlans[p];
+		const int blockSize = testPlan[0];
+
+		for (size_t c = 0; c < (sizeof(testChannelCounts) / sizeof(testChannelCounts[0])); c++) {
+			const int channelCount = testChannelCounts[c];
+			Convolver* const convolver = convolverAlloc(blockSize, TestMaximumKernelLength, channelCount);
+			if (!convolver) {
+				printf("convolverAlloc() failed\n");
+				return 1;
+			}
+
+			for (int ch = 0; ch < channelCount; ch++) {
+				float* const h = kernels + (ch * TestMaximumKernelLength);
+				kernelLengths[ch] = TestMaximumKernelLength - (ch * 1237);
+				const float scale = 1.0f / sqrtf((float)kernelLengths[ch]);
+				for (int k = 0; k < kernelLengths[ch]; k++)
+					h[k] = testRandom() * scale;
+				convolverChangeKernel(convolver, ch, h, kernelLengths[ch]);
+			}
+
+			// The first run does not end at the last step of the longest segment, so that the
+			// reset also happens while there is pending work
+			const int lastLength = convolver->segments[convolver->segmentCount - 1].partitionLength;
+			const int blockCount = ((TestMaximumKernelLength + (2 * lastLength)) / blockSize) + 3;
+			const int sampleCount = (blockCount | 1) * blockSize;
+			float* const input = (float*)malloc(sizeof(float) * channelCount * sampleCount);
+			float* const output = (float*)malloc(sizeof(float) * channelCount * sampleCount);
+			double* const expected = (double*)malloc(sizeof(double) * sampleCount);
+
+			const double error1 = testRun(convolver, kernels, kernelLengths, input, output, expected, sampleCount);
+			convolverReset(convolver);
+			const double error2 = testRun(convolver, kernels, kernelLengths, input, output, expected, sampleCount);
+
+			char plan[128];
+			int length = 0;
+			for (int s = 0; s < convolver->segmentCount; s++)
+				length += snprintf(plan + length, sizeof(plan) - length, "%s%dx%d", (s ? " " : ""), convolver->segments[s].partitionLength, convolver->segments[s].partitionCount);
+
+			const int ok = (error1 <= TestMaximumError && error2 <= TestMaximumError);
+			if (!ok)
+				failed = 1;
+			printf("%5d  %8d  %-39s  %.2e  %.2e%s\n", blockSize, channelCount, plan, error1, error2, (ok ? "" : "  FAILED"));
+
+			free(expected);
+			free(output);
+			free(input);
+			convolverFree(convolver);
+		}
+	}
+
+	free(kernels);
+
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed;
+}
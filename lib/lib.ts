@@ -44,19 +44,66 @@ interface CLib {
 	_fftFreef(fft4gfPtr: number): void;
 	_fftf(fft4gfPtr: number, dataPtr: number): void;
 	_fftif(fft4gfPtr: number, dataPtr: number): void;
+	_fftPair(fft4gPtr: number, dataPtr: number): void;
+	_fftPairi(fft4gPtr: number, dataPtr: number): void;
+	_fftPairf(fft4gfPtr: number, dataPtr: number): void;
+	_fftPairif(fft4gfPtr: number, dataPtr: number): void;
+	_fftPruned(fft4gPtr: number, dataPtr: number): void;
+	_fftPairPruned(fft4gPtr: number, dataPtr: number): void;
+	_fftPrunedf(fft4gfPtr: number, dataPtr: number): void;
+	_fftPairPrunedf(fft4gfPtr: number, dataPtr: number): void;
+	_fftPrunedBins(fft4gPtr: number, dataPtr: number, binCount: number): void;
+	_fftPrunedBinsf(fft4gfPtr: number, dataPtr: number, binCount: number): void;
+	_fftScratchSizeOf(n: number): number;
+	_fftChangeEngine(fft4gPtr: number, engine: number, scratchPtr: number): number;
+	_fftScratchSizeOff(n: number): number;
+	_fftChangeEnginef(fft4gfPtr: number, engine: number, scratchPtr: number): number;
+	_fftExportWisdom(blobPtr: number): void;
+	_fftImportWisdom(blobPtr: number): number;
+	_fftExportWisdomf(blobPtr: number): void;
+	_fftImportWisdomf(blobPtr: number): number;
+	_fftSetThreadCount(threadCount: number): number;
+	_fftSizeOfq15(n: number): number;
+	_fftInitq15(fftq15Ptr: number, n: number): number;
+	_fftAllocq15(n: number): number;
+	_fftFreeq15(fftq15Ptr: number): void;
+	_fftPairPrunedq15(fftq15Ptr: number, dataPtr: number): number;
+	_fftPairMagnitudesq15(fftq15Ptr: number, dataPtr: number, exponent: number, xPtr: number, yPtr: number, binCount: number): void;
 
-	_graphicalFilterEditorAlloc(filterLength: number, sampleRate: number): number;
+	_graphicalFilterEditorArenaAlloc(): number;
+	_graphicalFilterEditorArenaFree(arenaPtr: number): void;
+	_graphicalFilterEditorAllocInArena(arenaPtr: number, filterLength: number, sampleRate: number, channelCount: number): number;
+	_graphicalFilterEditorAlloc(filterLength: number, sampleRate: number, channelCount: number): number;
 	_graphicalFilterEditorGetFilterKernelBuffer(editorPtr: number): number;
+	_graphicalFilterEditorGetFilterKernels(editorPtr: number): number;
+	_graphicalFilterEditorGetChannelCount(editorPtr: number): number;
 	_graphicalFilterEditorGetChannelCurve(editorPtr: number, channel: number): number;
 	_graphicalFilterEditorGetActualChannelCurve(editorPtr: number): number;
 	_graphicalFilterEditorGetVisibleFrequencies(editorPtr: number): number;
 	_graphicalFilterEditorGetEquivalentZones(editorPtr: number): number;
 	_graphicalFilterEditorGetEquivalentZonesFrequencyCount(editorPtr: number): number;
-	_graphicalFilterEditorUpdateFilter(editorPtr: number, channelIndex: number, isNormalized: boolean): void;
+	_graphicalFilterEditorUpdateFilter(editorPtr: number, channelIndex: number, isNormalized: boolean, latency: number): void;
+	_graphicalFilterEditorUpdateFilterAndCurve(editorPtr: number, channelIndex: number, isNormalized: boolean, latency: number): void;
+	_graphicalFilterEditorUpdateFilters(editorPtr: number, channelMask: number, isNormalized: boolean, latency: number): void;
 	_graphicalFilterEditorUpdateActualChannelCurve(editorPtr: number, channelIndex: number): void;
-	_graphicalFilterEditorChangeFilterLength(editorPtr: number, newFilterLength: number): void;
+	_graphicalFilterEditorChangeFilterLength(editorPtr: number, newFilterLength: number): number;
+	_graphicalFilterEditorChangeSampleRate(editorPtr: number, newSampleRate: number): void;
+	_graphicalFilterEditorChangeBasisKernelsEnabled(editorPtr: number, enabled: boolean): number;
+	_graphicalFilterEditorChangeIsSinglePrecision(editorPtr: number, isSinglePrecision: boolean): number;
 	_graphicalFilterEditorFree(editorPtr: number): void;
+	_graphicalFilterEditorUpdateConvolver(editorPtr: number, convolverPtr: number, channelIndex: number): void;
 
-	_plainAnalyzer(fft4gfPtr: number, windowPtr: number, dataPtr: number, tmpPtr: number): void;
+	_convolverSizeOf(blockSize: number, maximumKernelLength: number, channelCount: number): number;
+	_convolverAlloc(blockSize: number, maximumKernelLength: number, channelCount: number): number;
+	_convolverFree(convolverPtr: number): void;
+	_convolverGetBlock(convolverPtr: number, channelIndex: number): number;
+	_convolverGetSegmentCount(convolverPtr: number): number;
+	_convolverGetSegmentPartitionLength(convolverPtr: number, segmentIndex: number): number;
+	_convolverGetSegmentPartitionCount(convolverPtr: number, segmentIndex: number): number;
+	_convolverChangeKernel(convolverPtr: number, channelIndex: number, kernelPtr: number, kernelLength: number): void;
+	_convolverReset(convolverPtr: number): void;
+	_convolverProcess(convolverPtr: number): void;
+
+	_plainAnalyzer(fft4gfPtr: number, fftq15Ptr: number, windowPtr: number, dataLPtr: number, dataRPtr: number, framePtr: number, tmpPtr: number, binCount: number): void;
 	_waveletAnalyzer(dataLPtr: number, dataRPtr: number, tmpPtr: number, oL1Ptr: number, oR1Ptr: number): void;
 }
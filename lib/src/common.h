@@ -24,6 +24,17 @@
 // https://github.com/carlosrafaelgn/GraphicalFilterEditor
 //
 
+// Native builds (see the bench target in Makefile) only need a replacement for
+// emscripten_get_now(), which is used by the FFT planner (see fft4g.c)
+#ifndef __EMSCRIPTEN__
+#include <time.h>
+static inline double emscripten_get_now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((double)now.tv_sec * 1000.0) + ((double)now.tv_nsec * 0.000001);
+}
+#endif
+
 // Must be in sync with scripts/graphicalFilterEditor/graphicalFilterEditor.ts
 // Sorry, but due to the frequency mapping I created, this class will only work with
 // 500 visible bins... in order to change this, a new frequency mapping must be created...
@@ -35,8 +46,14 @@
 #define MinusInfiniteChannelValue (MinimumChannelValue - 1)
 #define MaximumChannelValueY 0
 #define MinimumChannelValueY (ValidYRangeHeight - 1)
+// Filter lengths must be powers of 2
+#define MinimumFilterLength 8
 #define MaximumFilterLength 8192
+// The FFT layer itself is not bound to MaximumFilterLength (see fft4g.h)
+#define MaximumFFTLength 262144
 #define EquivalentZoneCount 10
+// 7.1
+#define MaximumChannelCount 8
 
 extern double lerp(double x0, double y0, double x1, double y1, double x);
 extern float lerpf(float x0, float y0, float x1, float y1, float x);
@@ -0,0 +1,663 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+#include "fft4g.h"
+#include "convolver.h"
+#include "simd.h"
+
+// Each partition of the kernel is stored as 4 + 4 floats for every 2 complex numbers
+// (every 4 floats of the spectrum): { re0, re0, re1, re1 } and { im0, im0, im1, im1 },
+// which is exactly what simdCMul() expects (see simd.h). Since the first 2 floats of
+// the spectrum are DC and Nyquist, both purely real, the first group is stored as
+// { dc, nyquist, re1, re1 } and { 0, 0, im1, im1 }, so they are also handled by the
+// same complex multiplication. This takes twice the memory, but no shuffles are
+// necessary to multiply the spectra.
+//
+// The segments with longer partitions (all but the first one) spread the work of each
+// block of partitionLength samples over stepCount calls to convolverProcess() (the steps,
+// see stepSegment()), while the next block is being gathered. Instead of a single
+// transform of 2 * partitionLength points, which would take a lot longer than the other
+// steps, each spectrum is computed from two transforms of partitionLength points (one for
+// the even samples, and another one for the odd samples, see combineHalves()), performed
+// by different steps (and the same goes for the inverse transform, see splitHalves()).
+// The multiplications are then distributed among the steps, so that all of them cost
+// about the same (see scheduleSegment()). The output of a block is ready by the end of its
+// last step, stepCount - 1 calls after the block was complete, and it is added to the
+// blocks during the following stepCount calls, which is why a segment with partitions of
+// length L can only start at (2 * L) - blockSize samples into the kernel.
+
+// Rough cost of a real transform of n points, in floats processed by multiplyAccumulate()
+// (measured natively, with SSE, from 256 to 8192 points: 0.64 to 0.81 * n * log2(n))
+static double transformCost(int n) {
+	int log2n = 0;
+	while ((1 << log2n) < n)
+		log2n++;
+	return 0.75 * (double)n * (double)log2n;
+}
+
+// Cost of the work each step of a segment (other than the first one) has to perform, besides
+// the multiplications (see stepSegment()), in the same unit used by transformCost():
+// combineHalves() and splitHalves() cost about as much as multiplyAccumulate() of
+// 2.5 * fftLength and 2 * fftLength floats, respectively, and the deinterleaving costs about
+// 1.5 * fftLength (interleaving costs half as much)
+static void fixedStepCosts(int partitionLength, int stepCount, double* fixedCost) {
+	const double halfCost = transformCost(partitionLength);
+	const double fftLength = (double)(partitionLength << 1);
+	for (int step = 0; step < stepCount; step++)
+		fixedCost[step] = 0.0;
+	if (stepCount > 2) {
+		fixedCost[0] = halfCost + (2.0 * fftLength);
+		fixedCost[1] = halfCost + (2.5 * fftLength);
+		fixedCost[stepCount - 2] = halfCost + (2.0 * fftLength);
+		fixedCost[stepCount - 1] = halfCost + fftLength;
+	} else {
+		fixedCost[0] = (2.0 * halfCost) + (4.5 * fftLength);
+		fixedCost[1] = (2.0 * halfCost) + (3.0 * fftLength);
+	}
+}
+
+// Cost of the most expensive call to convolverProcess() for a segment (the first segment
+// performs two transforms of 2 * partitionLength points per call, while the others spread
+// their work over all steps, but no step can cost less than its fixed cost)
+static double segmentCost(int blockSize, int partitionLength, int partitionCount, int isFirst) {
+	const int fftLength = (partitionLength << 1);
+	if (isFirst)
+		return (2.0 * transformCost(fftLength)) + (double)(partitionCount * fftLength);
+
+	const int stepCount = partitionLength / blockSize;
+	double fixedCost[ConvolverMaximumStepCount];
+	fixedStepCosts(partitionLength, stepCount, fixedCost);
+
+	double total = (double)(partitionCount * fftLength), peak = 0.0;
+	for (int step = 0; step < stepCount; step++) {
+		total += fixedCost[step];
+		if (peak < fixedCost[step])
+			peak = fixedCost[step];
+	}
+	total /= (double)stepCount;
+	return ((total > peak) ? total : peak);
+}
+
+// Every combination of segments (with partitions doubling from 2 * blockSize up to
+// ConvolverMaximumBlockSize) following the first one is evaluated, including none at all
+// (a uniform partition), and the one with the cheapest peak is kept (as if the most
+// expensive steps of all segments happened during the same call). Every segment ends exactly where the
+// next one can start, and only the last one extends all the way to maximumKernelLength.
+static int planSegments(int blockSize, int maximumKernelLength, int* partitionLengths, int* partitionCounts) {
+	int lengthCount = 0;
+	while ((blockSize << (lengthCount + 1)) <= ConvolverMaximumBlockSize)
+		lengthCount++;
+
+	double bestCost = 0.0;
+	int bestCount = 0;
+
+	for (int mask = 0; mask < (1 << lengthCount); mask++) {
+		int lengths[ConvolverMaximumSegmentCount], counts[ConvolverMaximumSegmentCount];
+		int count = 1;
+		lengths[0] = blockSize;
+		for (int i = 0; i < lengthCount; i++) {
+			if ((mask & (1 << i)))
+				lengths[count++] = (blockSize << (i + 1));
+		}
+
+		double cost = 0.0;
+		int s;
+		for (s = 0; s < count; s++) {
+			const int offset = (s ? ((lengths[s] << 1) - blockSize) : 0);
+			if (offset >= maximumKernelLength)
+				break;
+			counts[s] = (((s + 1) < count) ? (((lengths[s + 1] << 1) - blockSize - offset) / lengths[s]) :
+				((maximumKernelLength - offset + lengths[s] - 1) / lengths[s]));
+			cost += segmentCost(blockSize, lengths[s], counts[s], !s);
+		}
+
+		if (s == count && (!bestCount || cost < bestCost)) {
+			bestCost = cost;
+			bestCount = count;
+			memcpy(partitionLengths, lengths, sizeof(int) * count);
+			memcpy(partitionCounts, counts, sizeof(int) * count);
+		}
+	}
+
+	return bestCount;
+}
+
+// lib/bench/convolverTest.c includes this file after defining ConvolverPlanSegments, so
+// that it can also check plans planSegments() would not choose
+#ifndef ConvolverPlanSegments
+#define ConvolverPlanSegments planSegments
+#endif
+
+// Lays the segments out, along with their buffers (only when convolver is not null), and
+// returns how many floats all the buffers take
+static size_t layoutBuffers(Convolver* convolver, int blockSize, int maximumKernelLength, int channelCount) {
+	int partitionLengths[ConvolverMaximumSegmentCount], partitionCounts[ConvolverMaximumSegmentCount];
+	const int segmentCount = ConvolverPlanSegments(blockSize, maximumKernelLength, partitionLengths, partitionCounts);
+	const int maximumFFTLength = (partitionLengths[segmentCount - 1] << 1);
+
+	float* const buffer = (convolver ? convolver->buffer : 0);
+	size_t used = 0;
+
+	if (convolver)
+		convolver->segmentCount = segmentCount;
+
+	for (int s = 0; s < segmentCount; s++) {
+		const int partitionLength = partitionLengths[s], partitionCount = partitionCounts[s];
+		const int fftLength = (partitionLength << 1);
+
+		if (convolver) {
+			ConvolverSegment* const segment = convolver->segments + s;
+			segment->partitionLength = partitionLength;
+			segment->partitionCount = partitionCount;
+			segment->offset = (s ? (fftLength - blockSize) : 0);
+			segment->stepCount = partitionLength / blockSize;
+			segment->kernels = buffer + used;
+			segment->delayLines = segment->kernels + (channelCount * partitionCount * 2 * fftLength);
+			segment->inputs = segment->delayLines + (channelCount * partitionCount * fftLength);
+			segment->accums = segment->inputs + (channelCount * fftLength);
+			segment->outputs = segment->accums + ((s ? channelCount : 1) * fftLength);
+			segment->twiddles = segment->outputs + (s ? (channelCount * partitionLength) : 0);
+		}
+
+		used += (channelCount * partitionCount * 3 * fftLength) + // kernels and delayLines
+			((channelCount + (s ? channelCount : 1)) * fftLength) + // inputs and accums
+			(s ? ((channelCount + 1) * partitionLength) : 0); // outputs and twiddles
+	}
+
+	if (convolver) {
+		convolver->blocks = buffer + used;
+		convolver->scratch = convolver->blocks + (channelCount * blockSize);
+	}
+
+	return used + (channelCount * blockSize) + maximumFFTLength;
+}
+
+size_t convolverSizeOf(int blockSize, int maximumKernelLength, int channelCount) {
+	return sizeof(Convolver) + (sizeof(float) * layoutBuffers(0, blockSize, maximumKernelLength, channelCount));
+}
+
+// Assigns to each step a share of the multiplications of the segment (units of 4 floats
+// of a partition, see multiplyUnits()), so that all steps cost about the same, given the
+// transforms they also have to perform (see stepSegment())
+static void scheduleSegment(ConvolverSegment* segment) {
+	const int stepCount = segment->stepCount;
+	const int fftLength = (segment->partitionLength << 1);
+	const int groupCount = (fftLength >> 2);
+	const int unitCount = segment->partitionCount * groupCount;
+	const int lastMultiplyingStep = ((stepCount > 2) ? (stepCount - 2) : 1);
+
+	double fixedCost[ConvolverMaximumStepCount], share[ConvolverMaximumStepCount];
+	int step;
+
+	fixedStepCosts(segment->partitionLength, stepCount, fixedCost);
+
+	double total = (double)(unitCount << 2);
+	for (step = 0; step < stepCount; step++)
+		total += fixedCost[step];
+	const double target = total / (double)stepCount;
+
+	double sum = 0.0;
+	for (step = 0; step < stepCount; step++) {
+		share[step] = ((step <= lastMultiplyingStep && target > fixedCost[step]) ? (target - fixedCost[step]) : 0.0);
+		sum += share[step];
+	}
+
+	double accumulated = 0.0;
+	segment->macStart[0] = 0;
+	for (step = 0; step < stepCount; step++) {
+		accumulated += share[step];
+		segment->macStart[step + 1] = ((step >= lastMultiplyingStep || sum <= 0.0) ? unitCount : (int)(((double)unitCount * accumulated / sum) + 0.5));
+	}
+
+	// The newest spectrum is only complete after the second step, so the first step must
+	// not reach partition 0 (whose units are the last ones, see multiplyUnits())
+	if (stepCount > 2 && segment->macStart[1] > (unitCount - groupCount))
+		segment->macStart[1] = unitCount - groupCount;
+}
+
+// Returns 0 when there is not enough memory
+Convolver* convolverAlloc(int blockSize, int maximumKernelLength, int channelCount) {
+	Convolver* const convolver = (Convolver*)malloc(convolverSizeOf(blockSize, maximumKernelLength, channelCount));
+	if (!convolver)
+		return 0;
+	memset(convolver, 0, sizeof(Convolver));
+
+	convolver->blockSize = blockSize;
+	convolver->channelCount = channelCount;
+	layoutBuffers(convolver, blockSize, maximumKernelLength, channelCount);
+
+	for (int s = 0; s < convolver->segmentCount; s++) {
+		ConvolverSegment* const segment = convolver->segments + s;
+		const int partitionLength = segment->partitionLength;
+
+		segment->fft4gf = fftAllocf(s ? partitionLength : (partitionLength << 1));
+		if (!segment->fft4gf) {
+			convolverFree(convolver);
+			return 0;
+		}
+		if (!s)
+			continue;
+
+		// twiddles [2k] = cos(2 * pi * k / (2 * partitionLength)), twiddles [2k + 1] = sin(...)
+		float* const twiddles = segment->twiddles;
+		for (int k = (partitionLength >> 1) - 1; k >= 0; k--) {
+			const double angle = 3.14159265358979323846 * (double)k / (double)partitionLength;
+			twiddles[k << 1] = (float)cos(angle);
+			twiddles[(k << 1) + 1] = (float)sin(angle);
+		}
+
+		scheduleSegment(segment);
+	}
+
+	convolverReset(convolver);
+
+	// Until a kernel is provided, the samples just go through (delayed by blockSize)
+	const float impulse = 1.0f;
+	for (int ch = 0; ch < channelCount; ch++)
+		convolverChangeKernel(convolver, ch, &impulse, 1);
+
+	return convolver;
+}
+
+void convolverFree(Convolver* convolver) {
+	if (convolver) {
+		for (int s = 0; s < convolver->segmentCount; s++)
+			fftFreef(convolver->segments[s].fft4gf);
+		free(convolver);
+	}
+}
+
+float* convolverGetBlock(Convolver* convolver, int channelIndex) {
+	return convolver->blocks + (channelIndex * convolver->blockSize);
+}
+
+int convolverGetSegmentCount(Convolver* convolver) {
+	return convolver->segmentCount;
+}
+
+int convolverGetSegmentPartitionLength(Convolver* convolver, int segmentIndex) {
+	return convolver->segments[segmentIndex].partitionLength;
+}
+
+int convolverGetSegmentPartitionCount(Convolver* convolver, int segmentIndex) {
+	return convolver->segments[segmentIndex].partitionCount;
+}
+
+// data holds A, the spectrum of the even samples of a sequence of 2 * partitionLength
+// samples, followed by B, the spectrum of its odd samples (both ordered as described in
+// fft4g.h), and ends up holding X, the spectrum of the whole sequence, computed as
+// X [k] = A [k] + (W^k * B [k]), with W = e^(2 * pi * i / (2 * partitionLength)), as
+// fftf() uses positive exponents, and X [partitionLength - k] = conj(A [k] - (W^k * B [k])).
+// Both k and (partitionLength / 2) - k are handled at once, as their inputs and outputs
+// share the same positions of data.
+static void combineHalves(const float* twiddles, float* data, int partitionLength) {
+	const int L = partitionLength;
+	const float a0 = data[0], aNyquist = data[1], b0 = data[L], bNyquist = data[L + 1];
+	data[0] = a0 + b0;
+	data[1] = a0 - b0;
+	// X [partitionLength / 2] = A [partitionLength / 2] + (i * B [partitionLength / 2])
+	data[L] = aNyquist;
+	data[L + 1] = bNyquist;
+
+	for (int k = 1, k2 = (L >> 1) - 1; k <= k2; k++, k2--) {
+		const float ar = data[k << 1], ai = data[(k << 1) + 1];
+		const float br = data[L + (k << 1)], bi = data[L + (k << 1) + 1];
+		const float a2r = data[k2 << 1], a2i = data[(k2 << 1) + 1];
+		const float b2r = data[L + (k2 << 1)], b2i = data[L + (k2 << 1) + 1];
+
+		const float wr = twiddles[k << 1], wi = twiddles[(k << 1) + 1];
+		const float tr = (wr * br) - (wi * bi), ti = (wr * bi) + (wi * br);
+		const float w2r = twiddles[k2 << 1], w2i = twiddles[(k2 << 1) + 1];
+		const float t2r = (w2r * b2r) - (w2i * b2i), t2i = (w2r * b2i) + (w2i * b2r);
+
+		// X [partitionLength - k] is stored at (2 * partitionLength) - (2 * k) = L + (2 * k2)
+		data[k << 1] = ar + tr;
+		data[(k << 1) + 1] = ai + ti;
+		data[L + (k2 << 1)] = ar - tr;
+		data[L + (k2 << 1) + 1] = ti - ai;
+		data[k2 << 1] = a2r + t2r;
+		data[(k2 << 1) + 1] = a2i + t2i;
+		data[L + (k << 1)] = a2r - t2r;
+		data[L + (k << 1) + 1] = t2i - a2i;
+	}
+}
+
+// The opposite of combineHalves(): data holds Y, the spectrum of a sequence of
+// 2 * partitionLength samples, and ends up holding A, the spectrum of its even samples,
+// followed by B, the spectrum of its odd samples, computed as
+// A [k] = (Y [k] + Y [k + partitionLength]) / 2 and
+// B [k] = ((Y [k] - Y [k + partitionLength]) * conj(W^k)) / 2, where
+// Y [k + partitionLength] = conj(Y [partitionLength - k]), so that fftif() can take each
+// one of them separately.
+static void splitHalves(const float* twiddles, float* data, int partitionLength) {
+	const int L = partitionLength;
+	const float y0 = data[0], yNyquist = data[1], yr = data[L], yi = data[L + 1];
+	data[0] = 0.5f * (y0 + yNyquist);
+	data[1] = yr;
+	data[L] = 0.5f * (y0 - yNyquist);
+	data[L + 1] = yi;
+
+	for (int k = 1, k2 = (L >> 1) - 1; k <= k2; k++, k2--) {
+		// z = Y [k + partitionLength] = conj(Y [partitionLength - k]), stored at L + (2 * k2)
+		const float ar = data[k << 1], ai = data[(k << 1) + 1];
+		const float zr = data[L + (k2 << 1)], zi = -data[L + (k2 << 1) + 1];
+		const float a2r = data[k2 << 1], a2i = data[(k2 << 1) + 1];
+		const float z2r = data[L + (k << 1)], z2i = -data[L + (k << 1) + 1];
+
+		const float wr = twiddles[k << 1], wi = twiddles[(k << 1) + 1];
+		const float dr = ar - zr, di = ai - zi;
+		const float w2r = twiddles[k2 << 1], w2i = twiddles[(k2 << 1) + 1];
+		const float d2r = a2r - z2r, d2i = a2i - z2i;
+
+		data[k << 1] = 0.5f * (ar + zr);
+		data[(k << 1) + 1] = 0.5f * (ai + zi);
+		data[L + (k << 1)] = 0.5f * ((dr * wr) + (di * wi));
+		data[L + (k << 1) + 1] = 0.5f * ((di * wr) - (dr * wi));
+		data[k2 << 1] = 0.5f * (a2r + z2r);
+		data[(k2 << 1) + 1] = 0.5f * (a2i + z2i);
+		data[L + (k2 << 1)] = 0.5f * ((d2r * w2r) + (d2i * w2i));
+		data[L + (k2 << 1) + 1] = 0.5f * ((d2i * w2r) - (d2r * w2i));
+	}
+}
+
+// The length of kernel must not exceed partitionLength (the rest is zero-padded)
+static void transformPartition(ConvolverSegment* segment, int isFirst, float* scratch, const float* kernel, int length, float* partition) {
+	const int partitionLength = segment->partitionLength;
+	const int fftLength = (partitionLength << 1);
+
+	if (isFirst) {
+		memcpy(scratch, kernel, sizeof(float) * length);
+		if (length < partitionLength)
+			memset(scratch + length, 0, sizeof(float) * (partitionLength - length));
+
+		// The second half is just zero-padding, which fftPrunedf() does not even read
+		fftPrunedf(segment->fft4gf, scratch);
+	} else {
+		// Only the first partitionLength / 2 even (and odd) samples can be other than zero,
+		// so both halves are pruned
+		const int halfLength = (partitionLength >> 1);
+		float* const odd = scratch + partitionLength;
+		for (int i = 0; i < halfLength; i++) {
+			const int j = (i << 1);
+			scratch[i] = ((j < length) ? kernel[j] : 0.0f);
+			odd[i] = (((j + 1) < length) ? kernel[j + 1] : 0.0f);
+		}
+		fftPrunedf(segment->fft4gf, scratch);
+		fftPrunedf(segment->fft4gf, odd);
+		combineHalves(segment->twiddles, scratch, partitionLength);
+	}
+
+	for (int i = 0; i < fftLength; i += 4) {
+		float* const wr = partition + (i << 1);
+		float* const wi = wr + 4;
+		if (i) {
+			wr[0] = scratch[i];
+			wr[1] = scratch[i];
+			wi[0] = scratch[i + 1];
+			wi[1] = scratch[i + 1];
+		} else {
+			wr[0] = scratch[0];
+			wr[1] = scratch[1];
+			wi[0] = 0.0f;
+			wi[1] = 0.0f;
+		}
+		wr[2] = scratch[i + 2];
+		wr[3] = scratch[i + 2];
+		wi[2] = scratch[i + 3];
+		wi[3] = scratch[i + 3];
+	}
+}
+
+// Only the first samples of the kernel, up to the end of the last segment (which holds at
+// least maximumKernelLength samples), are used. The kernel may be changed between two calls
+// to convolverProcess() (the samples already in the FDLs are preserved, so the new kernel
+// takes effect immediately, although the blocks of the longer partitions that are halfway
+// through their steps end up computed partly with the previous kernel).
+void convolverChangeKernel(Convolver* convolver, int channelIndex, const float* kernel, int kernelLength) {
+	const ConvolverSegment* const last = convolver->segments + (convolver->segmentCount - 1);
+	const int maximumLength = last->offset + (last->partitionCount * last->partitionLength);
+	if (kernelLength > maximumLength)
+		kernelLength = maximumLength;
+
+	for (int s = 0; s < convolver->segmentCount; s++) {
+		ConvolverSegment* const segment = convolver->segments + s;
+		const int partitionLength = segment->partitionLength;
+		const int fftLength = (partitionLength << 1);
+		const int offset = segment->offset;
+		int partitionCount = ((kernelLength > offset) ? ((kernelLength - offset + partitionLength - 1) / partitionLength) : 0);
+		if (partitionCount > segment->partitionCount)
+			partitionCount = segment->partitionCount;
+		float* partition = segment->kernels + (channelIndex * segment->partitionCount * 2 * fftLength);
+
+		for (int p = 0; p < partitionCount; p++, partition += 2 * fftLength) {
+			const int start = offset + (p * partitionLength);
+			const int length = (((kernelLength - start) < partitionLength) ? (kernelLength - start) : partitionLength);
+			transformPartition(segment, !s, convolver->scratch, kernel + start, length, partition);
+		}
+
+		segment->channelPartitionCount[channelIndex] = partitionCount;
+	}
+}
+
+// Clears the input history of all channels (the kernels are preserved)
+void convolverReset(Convolver* convolver) {
+	const int channelCount = convolver->channelCount;
+	convolver->step = 0;
+	for (int s = 0; s < convolver->segmentCount; s++) {
+		ConvolverSegment* const segment = convolver->segments + s;
+		const int fftLength = (segment->partitionLength << 1);
+		segment->position = 0;
+		memset(segment->delayLines, 0, sizeof(float) * channelCount * segment->partitionCount * fftLength);
+		memset(segment->inputs, 0, sizeof(float) * channelCount * fftLength);
+		if (s) {
+			// The steps before the next first step still add to (and transform) the accums
+			memset(segment->accums, 0, sizeof(float) * channelCount * fftLength);
+			memset(segment->outputs, 0, sizeof(float) * channelCount * segment->partitionLength);
+		}
+	}
+	memset(convolver->blocks, 0, sizeof(float) * channelCount * convolver->blockSize);
+}
+
+// accum += x * partition (see the layout of the partitions at the top of this file)
+static void multiplyAccumulate(float* accum, const float* x, const float* partition, int length) {
+#ifdef FFT_SIMD
+	for (int i = 0; i < length; i += 4, partition += 8)
+		simdStore(accum + i, simdAdd(simdLoad(accum + i), simdCMul(simdLoad(x + i), simdLoad(partition), simdLoad(partition + 4))));
+#else
+	for (int i = 0; i < length; i += 4, partition += 8) {
+		const float re0 = x[i], im0 = x[i + 1], re1 = x[i + 2], im1 = x[i + 3];
+		accum[i] += (re0 * partition[0]) - (im0 * partition[4]);
+		accum[i + 1] += (im0 * partition[1]) + (re0 * partition[5]);
+		accum[i + 2] += (re1 * partition[2]) - (im1 * partition[6]);
+		accum[i + 3] += (im1 * partition[3]) + (re1 * partition[7]);
+	}
+#endif
+}
+
+// Performs the multiplications from unit start to unit end - 1 of a channel, where unit u
+// covers 4 floats of partition partitionCount - 1 - (u / groupCount), meaning the older
+// spectra are multiplied first
+static void multiplyUnits(const ConvolverSegment* segment, int channelIndex, float* accum, int start, int end) {
+	const int partitionCount = segment->partitionCount;
+	const int fftLength = (segment->partitionLength << 1);
+	const int groupCount = (fftLength >> 2);
+	const float* const delayLine = segment->delayLines + (channelIndex * partitionCount * fftLength);
+	const float* const kernels = segment->kernels + (channelIndex * partitionCount * 2 * fftLength);
+
+	while (start < end) {
+		const int p = partitionCount - 1 - (start / groupCount);
+		const int group = start % groupCount;
+		const int groupEnd = (((group + end - start) < groupCount) ? (group + end - start) : groupCount);
+		if (p < segment->channelPartitionCount[channelIndex]) {
+			int slot = segment->position - p;
+			if (slot < 0)
+				slot += partitionCount;
+			multiplyAccumulate(accum + (group << 2), delayLine + (slot * fftLength) + (group << 2), kernels + (p * 2 * fftLength) + (group << 3), (groupEnd - group) << 2);
+		}
+		start += groupEnd - group;
+	}
+}
+
+// The first segment is processed at once, as its output is necessary right away
+static void processFirstSegment(Convolver* convolver) {
+	ConvolverSegment* const segment = convolver->segments;
+	const int blockSize = convolver->blockSize;
+	const int fftLength = (blockSize << 1);
+	const int partitionCount = segment->partitionCount;
+	const int position = (((segment->position + 1) < partitionCount) ? (segment->position + 1) : 0);
+	FFT4gf* const fft4gf = segment->fft4gf;
+	float* const accum = segment->accums;
+
+	segment->position = position;
+
+	for (int ch = 0; ch < convolver->channelCount; ch++) {
+		float* const input = segment->inputs + (ch * fftLength);
+		float* const block = convolver->blocks + (ch * blockSize);
+		float* const delayLine = segment->delayLines + (ch * partitionCount * fftLength);
+		const float* partition = segment->kernels + (ch * partitionCount * 2 * fftLength);
+
+		// Overlap-save: the previous block is followed by the current one
+		memcpy(input + blockSize, block, sizeof(float) * blockSize);
+		float* const spectrum = delayLine + (position * fftLength);
+		memcpy(spectrum, input, sizeof(float) * fftLength);
+		fftf(fft4gf, spectrum);
+		memcpy(input, block, sizeof(float) * blockSize);
+
+		// Partition p is multiplied by the spectrum of the block that arrived p blocks ago
+		memset(accum, 0, sizeof(float) * fftLength);
+		int slot = position;
+		for (int p = segment->channelPartitionCount[ch]; p > 0; p--, partition += 2 * fftLength) {
+			multiplyAccumulate(accum, delayLine + (slot * fftLength), partition, fftLength);
+			if (--slot < 0)
+				slot = partitionCount - 1;
+		}
+
+		// Only the last blockSize samples are free from circular aliasing
+		fftif(fft4gf, accum);
+		memcpy(block, accum + blockSize, sizeof(float) * blockSize);
+	}
+}
+
+// Step 0 splits the block that has just been gathered into even and odd samples, and
+// transforms the even ones, step 1 transforms the odd ones and combines both halves, steps
+// stepCount - 2 and stepCount - 1 do the same, backwards, with the sum of the products, and
+// the multiplications are spread over steps 0 to stepCount - 2 (with only two steps, step 0
+// computes the whole spectrum, and step 1 the whole inverse transform).
+static void stepSegment(Convolver* convolver, ConvolverSegment* segment, int step) {
+	const int partitionLength = segment->partitionLength;
+	const int halfLength = (partitionLength >> 1);
+	const int fftLength = (partitionLength << 1);
+	const int stepCount = segment->stepCount;
+	const int oddStep = ((stepCount > 2) ? 1 : 0);
+	const int inverseStep = ((stepCount > 2) ? (stepCount - 2) : 1);
+	FFT4gf* const fft4gf = segment->fft4gf;
+
+	if (!step)
+		segment->position = (((segment->position + 1) < segment->partitionCount) ? (segment->position + 1) : 0);
+
+	for (int ch = 0; ch < convolver->channelCount; ch++) {
+		float* const input = segment->inputs + (ch * fftLength);
+		float* const accum = segment->accums + (ch * fftLength);
+		float* const spectrum = segment->delayLines + (ch * segment->partitionCount * fftLength) + (segment->position * fftLength);
+		int i;
+
+		if (!step) {
+			// Overlap-save: the previous block is followed by the current one
+			for (i = 0; i < partitionLength; i++) {
+				spectrum[i] = input[i << 1];
+				spectrum[partitionLength + i] = input[(i << 1) + 1];
+			}
+			memcpy(input, input + partitionLength, sizeof(float) * partitionLength);
+			fftf(fft4gf, spectrum);
+			memset(accum, 0, sizeof(float) * fftLength);
+		}
+
+		if (step == oddStep) {
+			fftf(fft4gf, spectrum + partitionLength);
+			combineHalves(segment->twiddles, spectrum, partitionLength);
+		}
+
+		multiplyUnits(segment, ch, accum, segment->macStart[step], segment->macStart[step + 1]);
+
+		if (step == inverseStep) {
+			splitHalves(segment->twiddles, accum, partitionLength);
+			fftif(fft4gf, accum);
+		}
+
+		if (step == (stepCount - 1)) {
+			fftif(fft4gf, accum + partitionLength);
+
+			// Only the last partitionLength samples (the upper halves of both the even and
+			// the odd samples) are free from circular aliasing
+			float* const output = segment->outputs + (ch * partitionLength);
+			for (i = 0; i < halfLength; i++) {
+				output[i << 1] = accum[halfLength + i];
+				output[(i << 1) + 1] = accum[partitionLength + halfLength + i];
+			}
+		}
+	}
+}
+
+// Filters blockSize samples of every channel, in place (see convolverGetBlock())
+void convolverProcess(Convolver* convolver) {
+	const int blockSize = convolver->blockSize;
+	const int channelCount = convolver->channelCount;
+	const int segmentCount = convolver->segmentCount;
+	const int step = convolver->step;
+	int s, ch, i;
+
+	// The segments with longer partitions take the input samples before they are replaced
+	for (s = 1; s < segmentCount; s++) {
+		ConvolverSegment* const segment = convolver->segments + s;
+		const int fftLength = (segment->partitionLength << 1);
+		const int position = segment->partitionLength + ((step & (segment->stepCount - 1)) * blockSize);
+		for (ch = 0; ch < channelCount; ch++)
+			memcpy(segment->inputs + (ch * fftLength) + position, convolver->blocks + (ch * blockSize), sizeof(float) * blockSize);
+	}
+
+	processFirstSegment(convolver);
+
+	for (s = 1; s < segmentCount; s++) {
+		ConvolverSegment* const segment = convolver->segments + s;
+		const int nextStep = ((step + 1) & (segment->stepCount - 1));
+
+		// The output of the previous block is added one slice at a time, right before the
+		// step that will eventually replace it with the output of the next block
+		for (ch = 0; ch < channelCount; ch++) {
+			float* const block = convolver->blocks + (ch * blockSize);
+			const float* const output = segment->outputs + (ch * segment->partitionLength) + (nextStep * blockSize);
+			for (i = 0; i < blockSize; i++)
+				block[i] += output[i];
+		}
+
+		stepSegment(convolver, segment, nextStep);
+	}
+
+	convolver->step = ((step + 1) & (convolver->segments[segmentCount - 1].stepCount - 1));
+}
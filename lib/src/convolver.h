@@ -0,0 +1,120 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+// Partitioned overlap-save convolution (must be included after fft4g.h)
+//
+// The kernel is split into segments, each one made of partitions of the same length, which
+// are zero-padded to twice their length and transformed only once, when the kernel changes
+// (see convolverChangeKernel()). Every segment keeps, for each channel, a frequency-domain
+// delay line (FDL) with the spectra of the last blocks of partitionLength input samples it
+// has gathered (each spectrum being computed from the previous block followed by the
+// current one), which are multiplied by the partitions of the segment, and transformed
+// back, keeping only the last partitionLength samples of the sum.
+//
+// The first segment has partitions of blockSize samples, and its output is ready as soon
+// as a block arrives, so the latency is always blockSize samples (the time it takes to
+// gather a block, plus the latency of the kernel itself). When the kernel is long enough,
+// it is followed by segments with longer partitions (a non-uniform partition), which are
+// much cheaper per sample, but whose outputs take longer to be ready. The work of each
+// block of those segments is spread over the convolverProcess() calls it takes to gather
+// the next block (see convolver.c), which is why a segment with partitions of length L
+// can only start at 2L - blockSize samples into the kernel. The segments are chosen by
+// planSegments(), according to maximumKernelLength, so that the most expensive calls are
+// as cheap as possible (for short kernels, a single segment is usually the best choice).
+//
+// Even so, with a blockSize of 128 the cost per sample is still about 3 times that of a
+// uniform partition with a large blockSize (around 0.030 to 0.040 us per sample per
+// channel natively, against 0.010 to 0.012 us with blockSize = 4096, for kernels of 8192
+// to 16384 samples). The later segments are already cheap. The floor is set by the first
+// segment, which must transform 2 * blockSize points forward and backward on every call,
+// and whose cost per sample does not shrink with the kernel. Spreading that work is not
+// possible without adding latency.
+//
+// blockSize must be a power of 2, from ConvolverMinimumBlockSize to
+// ConvolverMaximumBlockSize, and channelCount goes from 1 to MaximumChannelCount.
+#define ConvolverMinimumBlockSize 128
+#define ConvolverMaximumBlockSize 4096
+// Partitions go from blockSize to ConvolverMaximumBlockSize samples, doubling each time
+#define ConvolverMaximumSegmentCount 6
+#define ConvolverMaximumStepCount (ConvolverMaximumBlockSize / ConvolverMinimumBlockSize)
+
+typedef struct ConvolverSegmentStruct {
+	// The first partition starts at offset samples into the kernel
+	int partitionLength, partitionCount, offset;
+	// Number of blocks of blockSize samples in each partition, which is also the number of
+	// steps it takes to process a block of partitionLength samples (see stepSegment())
+	int stepCount;
+	// Slot of the FDLs holding the newest spectrum
+	int position;
+	// The kernel of a channel may not fill all the partitions
+	int channelPartitionCount[MaximumChannelCount];
+	// Multiplications performed by each step, from macStart[step] to macStart[step + 1]
+	// (see scheduleSegment())
+	int macStart[ConvolverMaximumStepCount + 1];
+	// Transforms of 2 * partitionLength points for the first segment, and of partitionLength
+	// points for the others (see transformPartition())
+	FFT4gf* fft4gf;
+	// cos/sin pairs used to combine/split the halves of the spectra (see combineHalves())
+	float* twiddles;
+	// Partitions of each channel, already transformed, stored as expected by
+	// multiplyAccumulate() (2 * 2 * partitionLength floats per partition, see convolver.c)
+	float* kernels;
+	// Spectra of the last partitionCount blocks of each channel (2 * partitionLength floats
+	// per spectrum, in the same order used by fftf())
+	float* delayLines;
+	// Last 2 * partitionLength input samples of each channel
+	float* inputs;
+	// Sum of the products of each channel, which is transformed back in place (the first
+	// segment transforms it back right away, so all channels share a single one)
+	float* accums;
+	// Last partitionLength output samples of each channel, added to the blocks one step at
+	// a time (unused by the first segment, whose output goes straight to the blocks)
+	float* outputs;
+} ConvolverSegment;
+
+typedef struct ConvolverStruct {
+	int blockSize, channelCount, segmentCount;
+	// Counts the calls to convolverProcess(), modulo the stepCount of the last segment
+	int step;
+	ConvolverSegment segments[ConvolverMaximumSegmentCount];
+	// Samples of the current block of each channel (blockSize floats per channel), which
+	// are replaced by the output samples by convolverProcess()
+	float* blocks;
+	// Work area used by convolverChangeKernel()
+	float* scratch;
+	float buffer[];
+} Convolver;
+
+extern size_t convolverSizeOf(int blockSize, int maximumKernelLength, int channelCount);
+extern Convolver* convolverAlloc(int blockSize, int maximumKernelLength, int channelCount);
+extern void convolverFree(Convolver* convolver);
+extern float* convolverGetBlock(Convolver* convolver, int channelIndex);
+extern int convolverGetSegmentCount(Convolver* convolver);
+extern int convolverGetSegmentPartitionLength(Convolver* convolver, int segmentIndex);
+extern int convolverGetSegmentPartitionCount(Convolver* convolver, int segmentIndex);
+extern void convolverChangeKernel(Convolver* convolver, int channelIndex, const float* kernel, int kernelLength);
+extern void convolverReset(Convolver* convolver);
+extern void convolverProcess(Convolver* convolver);
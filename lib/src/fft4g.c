@@ -44,30 +44,658 @@
 // https://www.jjj.de/fft/fftpage.html
 //
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#endif
 #include <stdlib.h>
 #include <memory.h>
+#include <math.h>
 #include "fft4g.h"
+#include "fftThreads.h"
 
+void cdft(int n, int isgn, double *a, int *ip, double *w);
+void bitrv2(int n, int *ip, double *a);
+void cftfsubpruned(int n, double *a, double *w);
+void rftfsub(int n, double *a, int nc, double *c);
 void rdft(int n, int isgn, double *a, int *ip, double *w);
+void makewt(int nw, int *ip, double *w);
+void makect(int nc, int *ip, double *c);
+
+// The cos/sin table is shared by all FFT4g instances. It is built only once, for the
+// largest n requested so far, and, since Ooura's routines accept tables built for a
+// larger n, it is reused for every smaller power of 2. This means instances only
+// hold the bit reversal work area (ip[2...]), which rdft() overwrites every time.
+static double* sharedW;
+static int sharedNw, sharedNc;
+
+// The exact bound, for the complex transform of n points used by fftPair(), is
+// 2+(1<<(int)(log(n+0.5)/log(2))/2), which is also enough for rdft() of n points
+static int fftIpLength(int n) {
+	int bits = 0;
+	while ((1 << bits) < n)
+		bits++;
+	return 2 + (1 << (bits >> 1));
+}
+
+static int fftPrepareSharedTable(int n) {
+	// According to the spec: length of w = n / 2
+	if (sharedW && n <= (sharedNw << 2))
+		return 1;
+	double* const w = (double*)malloc(sizeof(double) * (n / 2));
+	if (!w)
+		return 0;
+	// makewt() uses ip[2...] as work area
+	int* const ip = (int*)malloc(sizeof(int) * fftIpLength(n));
+	if (!ip) {
+		free(w);
+		return 0;
+	}
+	const int nw = n >> 2;
+	makewt(nw, ip, w);
+	makect(nw, ip, w + nw);
+	free(ip);
+	if (sharedW)
+		free(sharedW);
+	sharedW = w;
+	sharedNw = nw;
+	sharedNc = nw;
+	return 1;
+}
+
+// When n is not a power of 2, Ooura's routines cannot be used, and a mixed-radix plan
+// is built instead (radices 4, 2, 3, 5 and any other prime, in this order). The area
+// right after the structure holds the radices of n / 2 (or of n, when n is odd),
+// followed by the table of e^(i.2.pi.k/n), for k = 0...n-1, and by the work area. The
+// transforms are computed by the self-sorting Stockham algorithm, ping-ponging
+// between data and the work area. When n is even, the real transform of n points is
+// computed by a complex transform of n / 2 points (just like rdft() does).
+#define FFTMixedRadixCount 32
+
+// Goertzel is only worth it for a handful of bins (see fftPrunedBins())
+#define FFTGoertzelMaxBins 32
+// fftPruned() costs about as much as (log2(n) * FFTGoertzelCostMul / FFTGoertzelCostDiv)
+// bins computed by fftGoertzel() (measured natively)
+#define FFTGoertzelCostMul 4
+#define FFTGoertzelCostDiv 5
+
+// When the Stockham engine is selected for a power of 2 (see fftChangeEngine()), the
+// radices of n / 2 are stored in ip (which is only used as a work area by Ooura's
+// routines), the table of e^(i.2.pi.k/N), for k = 0...N-1, is shared by all instances
+// (N being the largest power of 2 requested so far, so the table is also valid for
+// any smaller power of 2, with a stride of N / n), and the work area is provided by
+// the caller.
+static double* sharedStockhamTable;
+static int sharedStockhamN;
+
+static int fftPrepareSharedStockhamTable(int n) {
+	if (sharedStockhamTable && n <= sharedStockhamN)
+		return 1;
+	double* const table = (double*)malloc(sizeof(double) * (n << 1));
+	if (!table)
+		return 0;
+	const double _2_PI_N = (2.0 * 3.1415926535897932384626433832795) / (double)n;
+	for (int k = 0; k < n; k++) {
+		table[(k << 1)] = (double)cos(_2_PI_N * (double)k);
+		table[(k << 1) + 1] = (double)sin(_2_PI_N * (double)k);
+	}
+	if (sharedStockhamTable)
+		free(sharedStockhamTable);
+	sharedStockhamTable = table;
+	sharedStockhamN = n;
+	return 1;
+}
+
+static double* fftMixedTable(FFT4g* fft4g) {
+	// The table is aligned on a 16-byte boundary
+	return (double*)(((size_t)(fft4g->ip + FFTMixedRadixCount) + 15) & ~(size_t)15);
+}
+
+static size_t fftMixedSizeOf(int n) {
+	// Table (2n) + work area (2n, or 4n when n is odd, since the real input must be
+	// extended to a complex one)
+	return sizeof(FFT4g) + (sizeof(int) * FFTMixedRadixCount) + 15 + (sizeof(double) * ((n & 1) ? (6 * n) : (4 * n)));
+}
+
+static int fftMixedFactor(int n, int* radices) {
+	int count = 0;
+	while (!(n & 3)) {
+		radices[count++] = 4;
+		n >>= 2;
+	}
+	if (!(n & 1)) {
+		radices[count++] = 2;
+		n >>= 1;
+	}
+	for (int p = 3; n > 1; p += 2) {
+		// n is prime
+		if (p * p > n)
+			p = n;
+		while (!(n % p)) {
+			radices[count++] = p;
+			n /= p;
+		}
+	}
+	return count;
+}
+
+static void fftMixedInit(FFT4g* fft4g, int n) {
+	fft4g->radixCount = fftMixedFactor((n & 1) ? n : (n >> 1), fft4g->ip);
+	double* const table = fftMixedTable(fft4g);
+	const double _2_PI_N = (2.0 * 3.1415926535897932384626433832795) / (double)n;
+	for (int k = 0; k < n; k++) {
+		table[(k << 1)] = (double)cos(_2_PI_N * (double)k);
+		table[(k << 1) + 1] = (double)sin(_2_PI_N * (double)k);
+	}
+}
+
+// In all stages below, the current transform has radix * m points, and there are s of
+// them (interleaved), so the input of the current butterfly is x[q + s * (p + t * m)]
+// (t = 0...radix-1), and its output goes to y[q + s * ((p * radix) + u)] (u =
+// 0...radix-1), after being multiplied by e^(isgn.i.2.pi.p.u/(radix * m)), which is
+// table[p * u * ts] (ts = s * the stride of the table). Only q = q0...s-1 are processed
+// (fftMixedComplex() always passes 0, as q0 only exists to mirror fft4gf.c, where the
+// SIMD stages may have already processed the first values of q).
+
+static void fftMixedRadix2(int m, int s, int q0, int ts, int isgn, const double* x, double* y, const double* table) {
+	const int d = (s * m) << 1;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1;
+		const double w1r = table[k1], w1i = isgn * table[k1 + 1];
+		for (int q = q0; q < s; q++) {
+			const double* const a = x + ((q + (s * p)) << 1);
+			double* const b = y + ((q + (s * (p << 1))) << 1);
+			const double x1r = a[0] - a[d], x1i = a[1] - a[d + 1];
+			b[0] = a[0] + a[d];
+			b[1] = a[1] + a[d + 1];
+			b[(s << 1)] = (w1r * x1r) - (w1i * x1i);
+			b[(s << 1) + 1] = (w1r * x1i) + (w1i * x1r);
+		}
+	}
+}
+
+static void fftMixedRadix3(int m, int s, int q0, int ts, int isgn, const double* x, double* y, const double* table) {
+	const int d = (s * m) << 1;
+	// sin(2 * pi / 3)
+	const double sn = isgn * 0.86602540378443864676372317075294;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1;
+		const double w1r = table[k1], w1i = isgn * table[k1 + 1];
+		const double w2r = table[k2], w2i = isgn * table[k2 + 1];
+		for (int q = q0; q < s; q++) {
+			const double* const a = x + ((q + (s * p)) << 1);
+			double* const b = y + ((q + (s * p * 3)) << 1);
+			const double t1r = a[d] + a[(d << 1)], t1i = a[d + 1] + a[(d << 1) + 1];
+			const double t2r = a[0] - (0.5 * t1r), t2i = a[1] - (0.5 * t1i);
+			const double t3r = sn * (a[d] - a[(d << 1)]), t3i = sn * (a[d + 1] - a[(d << 1) + 1]);
+			// b1 = t2 + i.t3, b2 = t2 - i.t3
+			const double b1r = t2r - t3i, b1i = t2i + t3r;
+			const double b2r = t2r + t3i, b2i = t2i - t3r;
+			b[0] = a[0] + t1r;
+			b[1] = a[1] + t1i;
+			b[(s << 1)] = (w1r * b1r) - (w1i * b1i);
+			b[(s << 1) + 1] = (w1r * b1i) + (w1i * b1r);
+			b[(s << 2)] = (w2r * b2r) - (w2i * b2i);
+			b[(s << 2) + 1] = (w2r * b2i) + (w2i * b2r);
+		}
+	}
+}
+
+static void fftMixedRadix4(int m, int s, int q0, int ts, int isgn, const double* x, double* y, const double* table) {
+	const int d = (s * m) << 1, s2 = s << 1;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1, k3 = k1 + k2;
+		const double w1r = table[k1], w1i = isgn * table[k1 + 1];
+		const double w2r = table[k2], w2i = isgn * table[k2 + 1];
+		const double w3r = table[k3], w3i = isgn * table[k3 + 1];
+		for (int q = q0; q < s; q++) {
+			const double* const a = x + ((q + (s * p)) << 1);
+			double* const b = y + ((q + (s * (p << 2))) << 1);
+			const double a1r = a[d], a1i = a[d + 1];
+			const double a2r = a[(d << 1)], a2i = a[(d << 1) + 1];
+			const double a3r = a[(d << 1) + d], a3i = a[(d << 1) + d + 1];
+			const double t0r = a[0] + a2r, t0i = a[1] + a2i;
+			const double t1r = a[0] - a2r, t1i = a[1] - a2i;
+			const double t2r = a1r + a3r, t2i = a1i + a3i;
+			// isgn.i.(a1 - a3)
+			const double t3r = isgn * (a3i - a1i), t3i = isgn * (a1r - a3r);
+			const double b1r = t1r + t3r, b1i = t1i + t3i;
+			const double b2r = t0r - t2r, b2i = t0i - t2i;
+			const double b3r = t1r - t3r, b3i = t1i - t3i;
+			b[0] = t0r + t2r;
+			b[1] = t0i + t2i;
+			b[s2] = (w1r * b1r) - (w1i * b1i);
+			b[s2 + 1] = (w1r * b1i) + (w1i * b1r);
+			b[(s2 << 1)] = (w2r * b2r) - (w2i * b2i);
+			b[(s2 << 1) + 1] = (w2r * b2i) + (w2i * b2r);
+			b[(s2 << 1) + s2] = (w3r * b3r) - (w3i * b3i);
+			b[(s2 << 1) + s2 + 1] = (w3r * b3i) + (w3i * b3r);
+		}
+	}
+}
+
+static void fftMixedRadix5(int m, int s, int q0, int ts, int isgn, const double* x, double* y, const double* table) {
+	const int d = (s * m) << 1, s2 = s << 1;
+	// cos(2 * pi / 5), cos(4 * pi / 5), sin(2 * pi / 5) and sin(4 * pi / 5)
+	const double c1 = 0.30901699437494742410229341718282;
+	const double c2 = -0.80901699437494742410229341718282;
+	const double s1 = isgn * 0.95105651629515357211643933337938;
+	const double s2n = isgn * 0.58778525229247312916870595463907;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1, k3 = k1 + k2, k4 = k2 << 1;
+		const double w1r = table[k1], w1i = isgn * table[k1 + 1];
+		const double w2r = table[k2], w2i = isgn * table[k2 + 1];
+		const double w3r = table[k3], w3i = isgn * table[k3 + 1];
+		const double w4r = table[k4], w4i = isgn * table[k4 + 1];
+		for (int q = q0; q < s; q++) {
+			const double* const a = x + ((q + (s * p)) << 1);
+			double* const b = y + ((q + (s * p * 5)) << 1);
+			const double a1r = a[d], a1i = a[d + 1];
+			const double a2r = a[(d << 1)], a2i = a[(d << 1) + 1];
+			const double a3r = a[(d << 1) + d], a3i = a[(d << 1) + d + 1];
+			const double a4r = a[(d << 2)], a4i = a[(d << 2) + 1];
+			const double t1r = a1r + a4r, t1i = a1i + a4i;
+			const double t2r = a2r + a3r, t2i = a2i + a3i;
+			const double t3r = a1r - a4r, t3i = a1i - a4i;
+			const double t4r = a2r - a3r, t4i = a2i - a3i;
+			const double e1r = a[0] + (c1 * t1r) + (c2 * t2r), e1i = a[1] + (c1 * t1i) + (c2 * t2i);
+			const double e2r = a[0] + (c2 * t1r) + (c1 * t2r), e2i = a[1] + (c2 * t1i) + (c1 * t2i);
+			const double o1r = (s1 * t3r) + (s2n * t4r), o1i = (s1 * t3i) + (s2n * t4i);
+			const double o2r = (s2n * t3r) - (s1 * t4r), o2i = (s2n * t3i) - (s1 * t4i);
+			// b1 = e1 + i.o1, b4 = e1 - i.o1, b2 = e2 + i.o2, b3 = e2 - i.o2
+			const double b1r = e1r - o1i, b1i = e1i + o1r;
+			const double b4r = e1r + o1i, b4i = e1i - o1r;
+			const double b2r = e2r - o2i, b2i = e2i + o2r;
+			const double b3r = e2r + o2i, b3i = e2i - o2r;
+			b[0] = a[0] + t1r + t2r;
+			b[1] = a[1] + t1i + t2i;
+			b[s2] = (w1r * b1r) - (w1i * b1i);
+			b[s2 + 1] = (w1r * b1i) + (w1i * b1r);
+			b[(s2 << 1)] = (w2r * b2r) - (w2i * b2i);
+			b[(s2 << 1) + 1] = (w2r * b2i) + (w2i * b2r);
+			b[(s2 << 1) + s2] = (w3r * b3r) - (w3i * b3i);
+			b[(s2 << 1) + s2 + 1] = (w3r * b3i) + (w3i * b3r);
+			b[(s2 << 2)] = (w4r * b4r) - (w4i * b4i);
+			b[(s2 << 2) + 1] = (w4r * b4i) + (w4i * b4r);
+		}
+	}
+}
+
+static void fftMixedRadixGeneric(int radix, int m, int s, int q0, int ts, int isgn, const double* x, double* y, const double* table) {
+	// radix is an odd prime, so t and radix - t are processed together, as are u and
+	// radix - u:
+	// b[u] = a[0] + sum(c[t.u].(a[t] + a[radix - t]) + i.s[t.u].(a[t] - a[radix - t]))
+	// b[radix - u] = a[0] + sum(c[t.u].(a[t] + a[radix - t]) - i.s[t.u].(a[t] - a[radix - t]))
+	const int d = (s * m) << 1, s2 = s << 1, half = radix >> 1;
+	// e^(isgn.i.2.pi.j/radix) = table[j * m * ts]
+	const int rts = m * ts;
+	for (int p = 0; p < m; p++) {
+		for (int q = q0; q < s; q++) {
+			const double* const a = x + ((q + (s * p)) << 1);
+			double* const b = y + ((q + (s * p * radix)) << 1);
+			double b0r = a[0], b0i = a[1];
+			for (int t = 1; t <= half; t++) {
+				b0r += a[t * d] + a[(radix - t) * d];
+				b0i += a[(t * d) + 1] + a[((radix - t) * d) + 1];
+			}
+			b[0] = b0r;
+			b[1] = b0i;
+			for (int u = 1; u <= half; u++) {
+				double er = a[0], ei = a[1], or = 0, oi = 0;
+				// j = (t * u) % radix
+				for (int t = 1, j = u; t <= half; t++) {
+					const double* const at = a + (t * d);
+					const double* const ant = a + ((radix - t) * d);
+					const int k = (j * rts) << 1;
+					const double c = table[k], sn = isgn * table[k + 1];
+					er += c * (at[0] + ant[0]);
+					ei += c * (at[1] + ant[1]);
+					or += sn * (at[0] - ant[0]);
+					oi += sn * (at[1] - ant[1]);
+					j += u;
+					if (j >= radix)
+						j -= radix;
+				}
+				const double bur = er - oi, bui = ei + or;
+				const double bvr = er + oi, bvi = ei - or;
+				const int ku = (p * u * ts) << 1, kv = (p * (radix - u) * ts) << 1;
+				const double wur = table[ku], wui = isgn * table[ku + 1];
+				const double wvr = table[kv], wvi = isgn * table[kv + 1];
+				b[u * s2] = (wur * bur) - (wui * bui);
+				b[(u * s2) + 1] = (wur * bui) + (wui * bur);
+				b[(radix - u) * s2] = (wvr * bvr) - (wvi * bvi);
+				b[((radix - u) * s2) + 1] = (wvr * bvi) + (wvi * bvr);
+			}
+		}
+	}
+}
+
+// Complex transform of m points (m = the product of all radices), using
+// table[tstride * k] as e^(i.2.pi.k/m). Returns either a or b, whichever holds the
+// result (the other one is destroyed).
+static double* fftMixedComplex(const int* radices, int radixCount, int m, int isgn, double* a, double* b, const double* table, int tstride) {
+	double* x = a;
+	double* y = b;
+	for (int r = 0, s = 1; r < radixCount; r++) {
+		const int radix = radices[r];
+		m /= radix;
+		switch (radix) {
+		case 2:
+			fftMixedRadix2(m, s, 0, s * tstride, isgn, x, y, table);
+			break;
+		case 3:
+			fftMixedRadix3(m, s, 0, s * tstride, isgn, x, y, table);
+			break;
+		case 4:
+			fftMixedRadix4(m, s, 0, s * tstride, isgn, x, y, table);
+			break;
+		case 5:
+			fftMixedRadix5(m, s, 0, s * tstride, isgn, x, y, table);
+			break;
+		default:
+			fftMixedRadixGeneric(radix, m, s, 0, s * tstride, isgn, x, y, table);
+			break;
+		}
+		s *= radix;
+		double* const t = x;
+		x = y;
+		y = t;
+	}
+	return x;
+}
+
+// Returns the stride of the table, whose entries are e^(i.2.pi.k/n)
+static int fftMixedBuffers(FFT4g* fft4g, const double** table, double** work) {
+	const int n = fft4g->n;
+	if ((n & (n - 1))) {
+		*table = fftMixedTable(fft4g);
+		*work = (double*)*table + (n << 1);
+		return 1;
+	}
+	*table = sharedStockhamTable;
+	*work = fft4g->scratch;
+	return sharedStockhamN / n;
+}
+
+// z[j] = x[2j] + i.x[2j+1], Z = DFT(z), h = n / 2
+// X[k] = E[k] + w^k.O[k], X[h - k] = conj(E[k] - w^k.O[k])
+// E[k] = (Z[k] + conj(Z[h - k])) / 2
+// O[k] = (Z[k] - conj(Z[h - k])) / 2i
+// Both functions below handle k = first...last (and h - k), and accept the same
+// buffer as input and output, as k and h - k are always read before being written
+static void fftRealSplit(int n, const double* z, double* data, const double* table, int tstride, int first, int last) {
+	for (int k = first; k <= last; k++) {
+		const int j = k << 1, j2 = n - j;
+		const double wr = table[j * tstride], wi = table[(j * tstride) + 1];
+		const double zkr = z[j], zki = z[j + 1], zhkr = z[j2], zhki = z[j2 + 1];
+		const double ekr = 0.5 * (zkr + zhkr), eki = 0.5 * (zki - zhki);
+		const double okr = 0.5 * (zki + zhki), oki = 0.5 * (zhkr - zkr);
+		const double wokr = (wr * okr) - (wi * oki), woki = (wr * oki) + (wi * okr);
+		data[j] = ekr + wokr;
+		data[j + 1] = eki + woki;
+		data[j2] = ekr - wokr;
+		data[j2 + 1] = woki - eki;
+	}
+}
+
+// The opposite of fftRealSplit(), from the spectrum (data) back to Z
+static void fftRealJoin(int n, const double* data, double* z, const double* table, int tstride, int first, int last) {
+	for (int k = first; k <= last; k++) {
+		const int j = k << 1, j2 = n - j;
+		const double wr = table[j * tstride], wi = table[(j * tstride) + 1];
+		const double xkr = data[j], xki = data[j + 1], xhkr = data[j2], xhki = data[j2 + 1];
+		const double ekr = 0.5 * (xkr + xhkr), eki = 0.5 * (xki - xhki);
+		// O[k] = (X[k] - conj(X[h - k])) . conj(w^k) / 2
+		const double dr = 0.5 * (xkr - xhkr), di = 0.5 * (xki + xhki);
+		const double okr = (wr * dr) + (wi * di), oki = (wr * di) - (wi * dr);
+		// Z[k] = E[k] + i.O[k], Z[h - k] = conj(E[k]) + i.conj(O[k])
+		z[j] = ekr - oki;
+		z[j + 1] = eki + okr;
+		z[j2] = ekr + oki;
+		z[j2 + 1] = okr - eki;
+	}
+}
+
+// Same scaling and ordering used by rdft() (see fft4g.h for the ordering used
+// when n is odd)
+static void fftMixedReal(FFT4g* fft4g, int isgn, double* data) {
+	const int n = fft4g->n;
+	const double* table;
+	double* work;
+	// table[tstride * k] = e^(i.2.pi.k/n)
+	const int tstride = fftMixedBuffers(fft4g, &table, &work);
+
+	if ((n & 1)) {
+		// The input is extended to a complex one, and the transform of n points is computed
+		if (isgn >= 0) {
+			for (int j = 0; j < n; j++) {
+				work[(j << 1)] = data[j];
+				work[(j << 1) + 1] = 0;
+			}
+			const double* const z = fftMixedComplex(fft4g->ip, fft4g->radixCount, n, 1, work, work + (n << 1), table, tstride);
+			data[0] = z[0];
+			for (int k = 1; k < n; k += 2) {
+				data[k] = z[k + 1];
+				data[k + 1] = z[k + 2];
+			}
+		} else {
+			// The output must be scaled by n / 2 (just like rdft()), therefore the
+			// spectrum is scaled by 1 / 2
+			work[0] = 0.5 * data[0];
+			work[1] = 0;
+			for (int k = 1; k < n; k += 2) {
+				const int j = (n << 1) - k - 1;
+				work[k + 1] = 0.5 * data[k];
+				work[k + 2] = 0.5 * data[k + 1];
+				work[j] = 0.5 * data[k];
+				work[j + 1] = -0.5 * data[k + 1];
+			}
+			const double* const z = fftMixedComplex(fft4g->ip, fft4g->radixCount, n, -1, work, work + (n << 1), table, tstride);
+			for (int j = 0; j < n; j++)
+				data[j] = z[j << 1];
+		}
+		return;
+	}
+
+	// z[j] = x[2j] + i.x[2j+1], Z = DFT(z), h = n / 2 (see fftRealSplit())
+	const int h = n >> 1;
+	if (isgn >= 0) {
+		const double* const z = fftMixedComplex(fft4g->ip, fft4g->radixCount, h, 1, data, work, table, tstride << 1);
+		const double z0r = z[0], z0i = z[1];
+		fftRealSplit(n, z, data, table, tstride, 1, h >> 1);
+		data[0] = z0r + z0i;
+		data[1] = z0r - z0i;
+	} else {
+		const double x0 = data[0], xh = data[1];
+		fftRealJoin(n, data, data, table, tstride, 1, h >> 1);
+		data[0] = 0.5 * (x0 + xh);
+		data[1] = 0.5 * (x0 - xh);
+		const double* const z = fftMixedComplex(fft4g->ip, fft4g->radixCount, h, -1, data, work, table, tstride << 1);
+		if (z != data)
+			memcpy(data, z, sizeof(double) * n);
+	}
+}
+
+// Same as fftPair(), but for the mixed-radix plan (without the final scaling)
+static void fftMixedPair(FFT4g* fft4g, int isgn, double* data) {
+	const int n = fft4g->n, n2 = n << 1;
+	const double* table;
+	double* work;
+	const int tstride = fftMixedBuffers(fft4g, &table, &work);
+	// The radices of n, instead of those of n / 2
+	int radices[FFTMixedRadixCount];
+	int radixCount = fft4g->radixCount;
+	memcpy(radices, fft4g->ip, sizeof(int) * radixCount);
+	if (!(n & 1))
+		radices[radixCount++] = 2;
+	// When n is odd, X[k] goes to data[2k - 1] and data[2k], instead of data[2k] and data[2k + 1]
+	const int odd = (n & 1), last = ((n - 1) >> 1);
+
+	if (isgn >= 0) {
+		double* z = fftMixedComplex(radices, radixCount, n, 1, data, work, table, tstride);
+		if (z == data) {
+			memcpy(work, data, sizeof(double) * n2);
+			z = work;
+		}
+		// X[k] = (Z[k] + conj(Z[n - k])) / 2
+		// Y[k] = (Z[k] - conj(Z[n - k])) / 2i
+		double* const y = data + n;
+		data[0] = z[0];
+		y[0] = z[1];
+		if (!odd) {
+			data[1] = z[n];
+			y[1] = z[n + 1];
+		}
+		for (int k = 1; k <= last; k++) {
+			const int j = k << 1, j2 = n2 - j, o = j - odd;
+			data[o] = 0.5 * (z[j] + z[j2]);
+			data[o + 1] = 0.5 * (z[j + 1] - z[j2 + 1]);
+			y[o] = 0.5 * (z[j + 1] + z[j2 + 1]);
+			y[o + 1] = 0.5 * (z[j2] - z[j]);
+		}
+	} else {
+		// Z[k] = X[k] + i.Y[k] and Z[n - k] = conj(X[k]) + i.conj(Y[k])
+		const double* const y = data + n;
+		work[0] = data[0];
+		work[1] = y[0];
+		if (!odd) {
+			work[n] = data[1];
+			work[n + 1] = y[1];
+		}
+		for (int k = 1; k <= last; k++) {
+			const int j = k << 1, j2 = n2 - j, o = j - odd;
+			work[j] = data[o] - y[o + 1];
+			work[j + 1] = data[o + 1] + y[o];
+			work[j2] = data[o] + y[o + 1];
+			work[j2 + 1] = y[o] - data[o + 1];
+		}
+		const double* const z = fftMixedComplex(radices, radixCount, n, -1, work, data, table, tstride);
+		if (z != data)
+			memcpy(data, z, sizeof(double) * n2);
+	}
+}
+
+// The planner runs each engine on about FFTPlannerWork / log2(n) points per trial
+// (long enough for the coarse timers provided by some browsers), and keeps the
+// fastest of FFTPlannerTrials trials. Below FFTPlannerMinimumN, the transforms are
+// so short that the call overhead dominates, and Ooura's routines are just used.
+#define FFTPlannerWork (1 << 20)
+#define FFTPlannerTrials 3
+#define FFTPlannerMinimumN 64
+#define FFTWisdomVersion 2
+// Only used by the planner and by the wisdom: FFTEngineOoura, with the large transforms
+// split among threads (see fftThreadsUsable()), which is only worth it when there are
+// enough cores (the four-step decomposition is slower than rdft() on a single one)
+#define FFTEngineOouraThreads 3
+
+// Engine chosen by FFTEngineAuto for each power of 2, indexed by log2(n): 0 when n
+// has not been measured yet, or engine + 1 (FFTEngineOouraThreads included, which
+// reflects the thread count at the time of the measurement) (see fftExportWisdom())
+static unsigned char wisdom[FFTWisdomSize - 1];
+
+static int fftPrepareEngine(FFT4g* fft4g, int n);
+static int fftThreadsUsable(FFT4g* fft4g);
+
+static int fftMeasureEngine(FFT4g* fft4g, int n) {
+	int log2n = 0;
+	while ((1 << log2n) < n)
+		log2n++;
+	if (wisdom[log2n])
+		return wisdom[log2n] - 1;
+	if (n < FFTPlannerMinimumN)
+		return FFTEngineOoura;
+
+	double* const data = (double*)malloc(sizeof(double) * n);
+	if (!data)
+		return FFTEngineOoura;
+	for (int i = 0; i < n; i++)
+		data[i] = (double)((i & 15) - 8);
+
+	// fft() and ffti() are called in turns, so that data never overflows
+	const int oldN = fft4g->n;
+	const int repetitions = 1 + (FFTPlannerWork / (n * (log2n + 1)));
+	int bestEngine = FFTEngineOoura;
+	// -1 means no measurement yet (a coarse timer may legitimately report 0)
+	double bestTime = -1;
+	fft4g->n = n;
+	static const int engines[] = { FFTEngineOoura, FFTEngineStockham, FFTEngineOouraThreads };
+	for (int e = 0; e < 3; e++) {
+		const int engine = engines[e];
+		fft4g->engine = ((engine == FFTEngineOouraThreads) ? FFTEngineOoura : engine);
+		if (!fftPrepareEngine(fft4g, n))
+			continue;
+		// Threads are measured separately, and only when they would actually be used
+		fft4g->threads = (engine == FFTEngineOouraThreads);
+		if (engine == FFTEngineOouraThreads && !fftThreadsUsable(fft4g))
+			continue;
+		fft(fft4g, data);
+		ffti(fft4g, data);
+		for (int t = 0; t < FFTPlannerTrials; t++) {
+			const double start = emscripten_get_now();
+			for (int r = 0; r < repetitions; r++) {
+				fft(fft4g, data);
+				ffti(fft4g, data);
+			}
+			const double time = emscripten_get_now() - start;
+			if (bestTime < 0 || time < bestTime) {
+				bestTime = time;
+				bestEngine = engine;
+			}
+		}
+	}
+	fft4g->n = oldN;
+	fft4g->engine = FFTEngineAuto;
+	free(data);
+
+	wisdom[log2n] = (unsigned char)(bestEngine + 1);
+	return bestEngine;
+}
+
+// Only for powers of 2
+static int fftPrepareEngine(FFT4g* fft4g, int n) {
+	int engine = fft4g->engine;
+	// The threads are always allowed when the engine is chosen by the caller
+	fft4g->threads = 1;
+	if (engine == FFTEngineAuto) {
+		engine = fftMeasureEngine(fft4g, n);
+		fft4g->threads = (engine == FFTEngineOouraThreads);
+		if (engine == FFTEngineOouraThreads)
+			engine = FFTEngineOoura;
+	}
+	if (engine == FFTEngineStockham) {
+		if (!fftPrepareSharedStockhamTable(n))
+			return 0;
+		fft4g->radixCount = fftMixedFactor(n >> 1, fft4g->ip);
+	} else {
+		fft4g->radixCount = 0;
+	}
+	return 1;
+}
 
 size_t fftSizeOf(int n) {
-    // According to the spec: length of w = n / 2
-	return sizeof(FFT4g) + (sizeof(double) * (n / 2));
+	return ((n & (n - 1)) ? fftMixedSizeOf(n) : (sizeof(FFT4g) + (sizeof(int) * fftIpLength(n))));
 }
 
 FFT4g* fftInit(FFT4g* fft4g, int n) {
-    if (n > MaximumFilterLength)
-        return 0;
+	// The shared table is only used when n is a power of 2
+	if (n < 2 || n > MaximumFFTLength || (!(n & (n - 1)) && !fftPrepareSharedTable(n)))
+		return 0;
 	memset(fft4g, 0, fftSizeOf(n));
 	fft4g->n = n;
-    fft4g->maxN = n;
+	fft4g->maxN = n;
+	if ((n & (n - 1)))
+		fftMixedInit(fft4g, n);
 	return fft4g;
 }
 
 FFT4g* fftAlloc(int n) {
-    // n must be a power of 2
-	return (((n & (n - 1)) || (n > MaximumFilterLength)) ? 0 : fftInit((FFT4g*)malloc(fftSizeOf(n)), n));
+	if (n < 2 || n > MaximumFFTLength)
+		return 0;
+	FFT4g* const fft4g = (FFT4g*)malloc(fftSizeOf(n));
+	if (fft4g && !fftInit(fft4g, n)) {
+		free(fft4g);
+		return 0;
+	}
+	return fft4g;
 }
 
 void fftFree(FFT4g* fft4g) {
@@ -76,23 +704,418 @@ void fftFree(FFT4g* fft4g) {
 }
 
 void fftChangeN(FFT4g* fft4g, int n) {
-    // n must be a power of 2
-    if ((n & (n - 1)) || n > fft4g->maxN)
-        return;
-    fft4g->n = n;
-    fft4g->ip[0] = 0;
-    fft4g->ip[1] = 0;
+	// n must fit in the area allocated for maxN
+	if (n < 2 || n > fft4g->maxN || n == fft4g->n || fftSizeOf(n) > fftSizeOf(fft4g->maxN))
+		return;
+	if ((n & (n - 1))) {
+		fftMixedInit(fft4g, n);
+	} else {
+		// The shared table was built for maxN or larger, unless maxN is not a power of 2
+		if (!fftPrepareSharedTable(n) || !fftPrepareEngine(fft4g, n))
+			return;
+	}
+	fft4g->n = n;
+}
+
+size_t fftScratchSizeOf(int n) {
+	return sizeof(double) * (n << 1);
+}
+
+int fftChangeEngine(FFT4g* fft4g, int engine, double* scratch) {
+	if (engine < FFTEngineOoura || engine > FFTEngineAuto || (engine != FFTEngineOoura && !scratch))
+		return 0;
+	// Plans for lengths that are not powers of 2 always use the Stockham algorithm,
+	// with their own work area
+	const int n = fft4g->n, oldEngine = fft4g->engine;
+	double* const oldScratch = fft4g->scratch;
+	fft4g->engine = engine;
+	fft4g->scratch = scratch;
+	if (!(n & (n - 1)) && !fftPrepareEngine(fft4g, n)) {
+		fft4g->engine = oldEngine;
+		fft4g->scratch = oldScratch;
+		return 0;
+	}
+	return 1;
+}
+
+void fftExportWisdom(unsigned char* blob) {
+	blob[0] = FFTWisdomVersion;
+	memcpy(blob + 1, wisdom, FFTWisdomSize - 1);
+}
+
+int fftImportWisdom(const unsigned char* blob) {
+	if (blob[0] != FFTWisdomVersion)
+		return 0;
+	for (int i = 1; i < FFTWisdomSize; i++) {
+		if (blob[i] > (FFTEngineOouraThreads + 1))
+			return 0;
+	}
+	// Only the entries already measured by the blob are replaced
+	for (int i = 1; i < FFTWisdomSize; i++) {
+		if (blob[i])
+			wisdom[i - 1] = blob[i];
+	}
+	return 1;
+}
+
+static void fftPrepareIp(FFT4g* fft4g) {
+	// Another instance could have made the shared table grow since the last call
+	fft4g->ip[0] = sharedNw;
+	fft4g->ip[1] = sharedNc;
+}
+
+// Transforms of FFTThreadsMinimumN points or more are split among all threads (see
+// fftSetThreadCount()), when the instance has a work area, by a four-step
+// decomposition of the complex transform of m = n / 2 points used by rdft(): z is
+// seen as a matrix of r rows and c columns (z[(c * j1) + j2], r <= c, both powers of
+// 2), whose columns are transformed first (and then multiplied by
+// e^(i.2.pi.j2.k1/m)), followed by its rows, which leaves Z[k1 + (r * k2)] at
+// z[(c * k1) + k2]. Every thread transforms a range of columns/rows, by calling
+// cdft() with its own bit reversal work area, and the rows are transposed into the
+// work area, right after being transformed (the inverse transform does everything
+// in the opposite order). There are three steps, with all threads in sync between
+// them, whose scaling and ordering are the same used by fftMixedReal().
+#define FFTThreadsMinimumN 16384
+// Columns are gathered/scattered in groups, so that all values read from a cache line
+// are used at once (fftThreadsColumns() requires count * FFTThreadsColumnGroup <= c,
+// which holds for any n >= 8192 when count <= FFTMaximumThreadCount)
+#define FFTThreadsColumnGroup 4
+// Long enough for the longest row (c <= 512, as MaximumFFTLength is 262144)
+#define FFTThreadsIpLength (2 + 32)
+
+typedef struct FFTThreadsJobStruct {
+	int n, r, c, isgn;
+	// table[tstride * k] = e^(i.2.pi.k/n)
+	int tstride;
+	double* data;
+	double* work;
+	const double* table;
+} FFTThreadsJob;
+
+static void fftThreadsColumns(void* context, int index, int count) {
+	const FFTThreadsJob* const job = (const FFTThreadsJob*)context;
+	const int r = job->r, c = job->c, r2 = r << 1, c2 = c << 1, isgn = job->isgn, tstride = job->tstride << 2;
+	const double* const table = job->table;
+	// The columns are in data during the forward transform, or in the first half of
+	// the work area during the inverse transform (the second half holds the columns
+	// gathered by each thread)
+	double* const a = ((isgn >= 0) ? job->data : job->work);
+	double* const buffer = job->work + job->n + (index * FFTThreadsColumnGroup * r2);
+	int ip[FFTThreadsIpLength];
+	ip[0] = sharedNw;
+	ip[1] = sharedNc;
+
+	const int groupCount = c / FFTThreadsColumnGroup;
+	for (int g = (groupCount * index) / count, lastG = (groupCount * (index + 1)) / count; g < lastG; g++) {
+		const int j2 = g * FFTThreadsColumnGroup;
+		for (int j1 = 0; j1 < r; j1++) {
+			const double* const src = a + (j1 * c2) + (j2 << 1);
+			for (int i = 0; i < FFTThreadsColumnGroup; i++) {
+				buffer[(i * r2) + (j1 << 1)] = src[(i << 1)];
+				buffer[(i * r2) + (j1 << 1) + 1] = src[(i << 1) + 1];
+			}
+		}
+		for (int i = 0; i < FFTThreadsColumnGroup; i++) {
+			double* const column = buffer + (i * r2);
+			cdft(r2, isgn, column, ip, sharedW);
+			// column[k1] *= e^(isgn.i.2.pi.j2.k1/m), and j2.k1 < m
+			for (int k1 = 1; k1 < r; k1++) {
+				const double* const w = table + ((j2 + i) * k1 * tstride);
+				const double wr = w[0], wi = ((isgn >= 0) ? w[1] : -w[1]);
+				const double xr = column[(k1 << 1)], xi = column[(k1 << 1) + 1];
+				column[(k1 << 1)] = (xr * wr) - (xi * wi);
+				column[(k1 << 1) + 1] = (xr * wi) + (xi * wr);
+			}
+		}
+		for (int k1 = 0; k1 < r; k1++) {
+			double* const dst = a + (k1 * c2) + (j2 << 1);
+			for (int i = 0; i < FFTThreadsColumnGroup; i++) {
+				dst[(i << 1)] = buffer[(i * r2) + (k1 << 1)];
+				dst[(i << 1) + 1] = buffer[(i * r2) + (k1 << 1) + 1];
+			}
+		}
+	}
+}
+
+static void fftThreadsRows(void* context, int index, int count) {
+	const FFTThreadsJob* const job = (const FFTThreadsJob*)context;
+	const int r = job->r, c = job->c, r2 = r << 1, c2 = c << 1, isgn = job->isgn;
+	// Rows are transformed in place and transposed into the other buffer
+	double* const a = ((isgn >= 0) ? job->data : job->work);
+	double* const b = ((isgn >= 0) ? job->work : job->data);
+	int ip[FFTThreadsIpLength];
+	ip[0] = sharedNw;
+	ip[1] = sharedNc;
+
+	for (int k1 = (r * index) / count, lastK1 = (r * (index + 1)) / count; k1 < lastK1; k1++) {
+		double* const row = a + (k1 * c2);
+		cdft(c2, isgn, row, ip, sharedW);
+		double* const dst = b + (k1 << 1);
+		for (int k2 = 0; k2 < c; k2++) {
+			dst[k2 * r2] = row[(k2 << 1)];
+			dst[(k2 * r2) + 1] = row[(k2 << 1) + 1];
+		}
+	}
+}
+
+static void fftThreadsSplit(void* context, int index, int count) {
+	const FFTThreadsJob* const job = (const FFTThreadsJob*)context;
+	const int n = job->n, h2 = n >> 2;
+	// k = 1...h/2 (k = 0 is handled by the caller)
+	const int first = 1 + ((h2 * index) / count), last = (h2 * (index + 1)) / count;
+	if (job->isgn >= 0)
+		fftRealSplit(n, job->work, job->data, job->table, job->tstride, first, last);
+	else
+		fftRealJoin(n, job->data, job->work, job->table, job->tstride, first, last);
+}
+
+static int fftThreadsUsable(FFT4g* fft4g) {
+	const int n = fft4g->n;
+	// The table of e^(i.2.pi.k/n) is the one used by the Stockham engine
+	return (n >= FFTThreadsMinimumN && fft4g->threads && fft4g->scratch && !fft4g->radixCount && fftThreadsCount() > 1 && fftPrepareSharedStockhamTable(n));
+}
+
+static void fftThreadsReal(FFT4g* fft4g, int isgn, double* data) {
+	const int n = fft4g->n, m = n >> 1;
+	int log2m = 0;
+	while ((1 << log2m) < m)
+		log2m++;
+	FFTThreadsJob job;
+	job.n = n;
+	job.r = 1 << (log2m >> 1);
+	job.c = m >> (log2m >> 1);
+	job.isgn = isgn;
+	job.tstride = sharedStockhamN / n;
+	job.data = data;
+	job.work = fft4g->scratch;
+	job.table = sharedStockhamTable;
+	double* const z = job.work;
+
+	if (isgn >= 0) {
+		fftThreadsRun(fftThreadsColumns, &job);
+		fftThreadsRun(fftThreadsRows, &job);
+		fftThreadsRun(fftThreadsSplit, &job);
+		data[0] = z[0] + z[1];
+		data[1] = z[0] - z[1];
+	} else {
+		z[0] = 0.5 * (data[0] + data[1]);
+		z[1] = 0.5 * (data[0] - data[1]);
+		fftThreadsRun(fftThreadsSplit, &job);
+		fftThreadsRun(fftThreadsColumns, &job);
+		fftThreadsRun(fftThreadsRows, &job);
+	}
 }
 
 void fft(FFT4g* fft4g, double* data) {
-	rdft(fft4g->n, 1, data, fft4g->ip, fft4g->w);
+	if (fft4g->radixCount) {
+		fftMixedReal(fft4g, 1, data);
+		return;
+	}
+	if (fftThreadsUsable(fft4g)) {
+		fftThreadsReal(fft4g, 1, data);
+		return;
+	}
+	fftPrepareIp(fft4g);
+	rdft(fft4g->n, 1, data, fft4g->ip, sharedW);
 }
 
 void ffti(FFT4g* fft4g, double* data) {
-	rdft(fft4g->n, -1, data, fft4g->ip, fft4g->w);
-    const double _2_N = 2.0 / (double)fft4g->n;
-    for (int i = fft4g->n - 1; i >= 0; i--)
-        data[i] *= _2_N;
+	if (fft4g->radixCount) {
+		fftMixedReal(fft4g, -1, data);
+	} else if (fftThreadsUsable(fft4g)) {
+		fftThreadsReal(fft4g, -1, data);
+	} else {
+		fftPrepareIp(fft4g);
+		rdft(fft4g->n, -1, data, fft4g->ip, sharedW);
+	}
+	const double _2_N = 2.0 / (double)fft4g->n;
+	for (int i = fft4g->n - 1; i >= 0; i--)
+		data[i] *= _2_N;
+}
+
+static void fftPairSplit(int n, double* data) {
+	// Z[k] = X[k] + i.Y[k], and since x and y are real:
+	// X[k] = (Z[k] + conj(Z[n - k])) / 2
+	// Y[k] = (Z[k] - conj(Z[n - k])) / 2i
+	// X[k] is stored where Z[k] was, and Y[k] where Z[n/2 + k] was, so k and n/2 - k
+	// are processed together, as they read and write the same four positions:
+	// k, n - k, n/2 - k and n/2 + k
+	const double t = data[1];
+	data[1] = data[n];
+	data[n] = t;
+	for (int k = (n >> 2); k >= 1; k--) {
+		const int j = k << 1, jn = n - j, jn2 = n + j, j2 = (n << 1) - j;
+		const double zkr = data[j], zki = data[j + 1];
+		const double znkr = data[j2], znki = data[j2 + 1];
+		const double zn2kr = data[jn], zn2ki = data[jn + 1];
+		const double zn2pkr = data[jn2], zn2pki = data[jn2 + 1];
+		// X[k] and Y[k]
+		data[j] = 0.5 * (zkr + znkr);
+		data[j + 1] = 0.5 * (zki - znki);
+		data[jn2] = 0.5 * (zki + znki);
+		data[jn2 + 1] = 0.5 * (znkr - zkr);
+		// X[n/2 - k] and Y[n/2 - k]
+		data[jn] = 0.5 * (zn2kr + zn2pkr);
+		data[jn + 1] = 0.5 * (zn2ki - zn2pki);
+		data[j2] = 0.5 * (zn2ki + zn2pki);
+		data[j2 + 1] = 0.5 * (zn2pkr - zn2kr);
+	}
+}
+
+void fftPair(FFT4g* fft4g, double* data) {
+	if (fft4g->radixCount) {
+		fftMixedPair(fft4g, 1, data);
+		return;
+	}
+	const int n = fft4g->n;
+	// The complex transform of n points requires a table twice as large as the one
+	// required by the real transform of n points
+	if (!fftPrepareSharedTable(n << 1))
+		return;
+	fftPrepareIp(fft4g);
+	cdft(n << 1, 1, data, fft4g->ip, sharedW);
+	fftPairSplit(n, data);
+}
+
+void fftPairi(FFT4g* fft4g, double* data) {
+	const int n = fft4g->n;
+	if (fft4g->radixCount) {
+		fftMixedPair(fft4g, -1, data);
+	} else {
+		if (!fftPrepareSharedTable(n << 1))
+			return;
+
+		// Z[k] = X[k] + i.Y[k] and Z[n - k] = conj(X[k]) + i.conj(Y[k]), using the same
+		// positions used by fftPair()
+		const double t = data[1];
+		data[1] = data[n];
+		data[n] = t;
+		for (int k = (n >> 2); k >= 1; k--) {
+			const int j = k << 1, jn = n - j, jn2 = n + j, j2 = (n << 1) - j;
+			const double xkr = data[j], xki = data[j + 1];
+			const double ykr = data[jn2], yki = data[jn2 + 1];
+			const double xn2kr = data[jn], xn2ki = data[jn + 1];
+			const double yn2kr = data[j2], yn2ki = data[j2 + 1];
+			// Z[k] and Z[n - k]
+			data[j] = xkr - yki;
+			data[j + 1] = xki + ykr;
+			data[j2] = xkr + yki;
+			data[j2 + 1] = ykr - xki;
+			// Z[n/2 - k] and Z[n/2 + k]
+			data[jn] = xn2kr - yn2ki;
+			data[jn + 1] = xn2ki + yn2kr;
+			data[jn2] = xn2kr + yn2ki;
+			data[jn2 + 1] = yn2kr - xn2ki;
+		}
+
+		fftPrepareIp(fft4g);
+		cdft(n << 1, -1, data, fft4g->ip, sharedW);
+	}
+	const double _1_N = 1.0 / (double)n;
+	for (int i = (n << 1) - 1; i >= 0; i--)
+		data[i] *= _1_N;
+}
+
+void fftPruned(FFT4g* fft4g, double* data) {
+	const int n = fft4g->n;
+	// The mixed-radix plans and the small sizes just clear the upper half
+	if (fft4g->radixCount || n < 16) {
+		// When n is odd, the upper half has one more element than the lower one
+		memset(data + (n >> 1), 0, sizeof(double) * (n - (n >> 1)));
+		fft(fft4g, data);
+		return;
+	}
+	fftPrepareIp(fft4g);
+	// Same as rdft(n, 1, ...), but only the lower half goes through the bit reversal
+	bitrv2(n >> 1, fft4g->ip + 2, data);
+	cftfsubpruned(n, data, sharedW);
+	rftfsub(n, data, sharedNc, sharedW + sharedNw);
+	const double xi = data[0] - data[1];
+	data[0] += data[1];
+	data[1] = xi;
+}
+
+void fftPairPruned(FFT4g* fft4g, double* data) {
+	const int n = fft4g->n;
+	if (fft4g->radixCount || n < 8) {
+		// x [n/2] and y [n/2] start at 2 * (n/2), which is n - 1 when n is odd
+		memset(data + ((n >> 1) << 1), 0, sizeof(double) * ((n << 1) - ((n >> 1) << 1)));
+		fftPair(fft4g, data);
+		return;
+	}
+	if (!fftPrepareSharedTable(n << 1))
+		return;
+	fftPrepareIp(fft4g);
+	// Same as cdft(2n, 1, ...), but only the lower half goes through the bit reversal
+	bitrv2(n, fft4g->ip + 2, data);
+	cftfsubpruned(n << 1, data, sharedW);
+	fftPairSplit(n, data);
+}
+
+static int fftPrunedBinsUseGoertzel(int n, int binCount) {
+	// fftGoertzel() requires all bins to be below n/4 (see below)
+	if (binCount > FFTGoertzelMaxBins || binCount > (n >> 2))
+		return 0;
+	// Rough cost model: each bin costs n/2 iterations of the Goertzel recurrence
+	// (bins are computed in groups of 4), while the cost of the transform grows with
+	// n * log2(n)
+	int log2n = 0;
+	while ((1 << log2n) < n)
+		log2n++;
+	return ((((binCount + 3) & ~3) * FFTGoertzelCostDiv) <= (log2n * FFTGoertzelCostMul));
+}
+
+static void fftGoertzel(int n, int binCount, double* data) {
+	// Only data [0...n/2-1] is read (the rest is assumed to be zero). The recurrence
+	// runs backwards (Clenshaw), so that sum(x [j] * e^(i*w*j)) = b0 - (e^(-i*w) * b1).
+	// Four bins are computed at a time, to break the dependency chain of the recurrence
+	// (the extra bins of the last group are computed and thrown away).
+	//
+	// The plain recurrence (a = x + (2 * cos(w) * a) - b) loses precision as n grows,
+	// because 2 * cos(w) gets too close to 2 for the low bins, so Reinsch's modification
+	// is used instead: it keeps d = a - b, updated with l = 2 * cos(w) - 2 =
+	// -4 * sin(w/2)^2, which is computed accurately. It only holds while cos(w) > 0,
+	// which is why fftPrunedBinsUseGoertzel() never lets a bin reach n/4.
+	double bins[FFTGoertzelMaxBins << 1];
+	const int m = n >> 1;
+	const double w = 6.283185307179586476925286766559 / (double)n;
+	for (int k = 0; k < binCount; k += 4) {
+		const double s0 = sin(0.5 * w * (double)k), s1 = sin(0.5 * w * (double)(k + 1)),
+			s2 = sin(0.5 * w * (double)(k + 2)), s3 = sin(0.5 * w * (double)(k + 3));
+		const double l0 = -4.0 * s0 * s0, l1 = -4.0 * s1 * s1,
+			l2 = -4.0 * s2 * s2, l3 = -4.0 * s3 * s3;
+		double a0 = 0, a1 = 0, a2 = 0, a3 = 0, d0 = 0, d1 = 0, d2 = 0, d3 = 0;
+		for (int j = m - 1; j > 0; j--) {
+			const double x = data[j];
+			d0 += (l0 * a0) + x; a0 += d0;
+			d1 += (l1 * a1) + x; a1 += d1;
+			d2 += (l2 * a2) + x; a2 += d2;
+			d3 += (l3 * a3) + x; a3 += d3;
+		}
+		// The last iteration (j = 0) is left out, so that a holds b1 in the end, and
+		// b0 - (e^(-i*w) * b1) = (d + x [0] + ((l / 2) * b1)) + (i * sin(w) * b1)
+		const double x = data[0];
+		double* const bin = bins + (k << 1);
+		bin[0] = d0 + x + (0.5 * l0 * a0);
+		bin[1] = sin(w * (double)k) * a0;
+		bin[2] = d1 + x + (0.5 * l1 * a1);
+		bin[3] = sin(w * (double)(k + 1)) * a1;
+		bin[4] = d2 + x + (0.5 * l2 * a2);
+		bin[5] = sin(w * (double)(k + 2)) * a2;
+		bin[6] = d3 + x + (0.5 * l3 * a3);
+		bin[7] = sin(w * (double)(k + 3)) * a3;
+	}
+	// data [1] should hold the Nyquist bin, which is not computed here (bin 0 has
+	// no imaginary part, so it is just left as 0)
+	memcpy(data, bins, sizeof(double) * (binCount << 1));
+}
+
+void fftPrunedBins(FFT4g* fft4g, double* data, int binCount) {
+	const int n = fft4g->n;
+	if (fft4g->radixCount || !fftPrunedBinsUseGoertzel(n, binCount))
+		fftPruned(fft4g, data);
+	else
+		fftGoertzel(n, binCount, data);
 }
 
 /*
@@ -1220,6 +2243,150 @@ void cft1st(int n, double *a, double *w)
 }
 
 
+void cft1stpruned(int n, double *a, double *w)
+{
+    /*
+    Same as cft1st(), but only a[0...n/2-1] holds data, in the order
+    left by bitrv2(n/2), as the upper half of the original input was
+    zero. Therefore, the element at position p must go to position 2p,
+    and the odd (complex) positions are zero. The blocks are processed
+    in descending order, so that a[0...n/2-1] is consumed before being
+    overwritten, and the remaining of a[] is never read.
+    */
+    int j, k1, k2;
+    double wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
+    double x0r, x0i, x1r, x1i, x2r, x2i;
+    double *b;
+    
+    for (j = n - 16; j >= 16; j -= 16) {
+        b = a + (j >> 1);
+        k1 = j >> 3;
+        k2 = 2 * k1;
+        wk2r = w[k1];
+        wk2i = w[k1 + 1];
+        wk1r = w[k2 + 2];
+        wk1i = w[k2 + 3];
+        wk3r = wk1r - 2 * wk2r * wk1i;
+        wk3i = 2 * wk2r * wk1r - wk1i;
+        x0r = b[4] + b[6];
+        x0i = b[5] + b[7];
+        x1r = b[4] - b[6];
+        x1i = b[5] - b[7];
+        x2r = b[4] - b[7];
+        x2i = b[5] + b[6];
+        a[j + 8] = x0r;
+        a[j + 9] = x0i;
+        a[j + 12] = -wk2i * x1r - wk2r * x1i;
+        a[j + 13] = -wk2i * x1i + wk2r * x1r;
+        a[j + 10] = wk1r * x2r - wk1i * x2i;
+        a[j + 11] = wk1r * x2i + wk1i * x2r;
+        x2r = b[4] + b[7];
+        x2i = b[5] - b[6];
+        a[j + 14] = wk3r * x2r - wk3i * x2i;
+        a[j + 15] = wk3r * x2i + wk3i * x2r;
+        wk1r = w[k2];
+        wk1i = w[k2 + 1];
+        wk3r = wk1r - 2 * wk2i * wk1i;
+        wk3i = 2 * wk2i * wk1r - wk1i;
+        x0r = b[0] + b[2];
+        x0i = b[1] + b[3];
+        x1r = b[0] - b[2];
+        x1i = b[1] - b[3];
+        x2r = b[0] - b[3];
+        x2i = b[1] + b[2];
+        a[j] = x0r;
+        a[j + 1] = x0i;
+        a[j + 4] = wk2r * x1r - wk2i * x1i;
+        a[j + 5] = wk2r * x1i + wk2i * x1r;
+        a[j + 2] = wk1r * x2r - wk1i * x2i;
+        a[j + 3] = wk1r * x2i + wk1i * x2r;
+        x2r = b[0] + b[3];
+        x2i = b[1] - b[2];
+        a[j + 6] = wk3r * x2r - wk3i * x2i;
+        a[j + 7] = wk3r * x2i + wk3i * x2r;
+    }
+    wk1r = w[2];
+    x0r = a[4] - a[7];
+    x0i = a[5] + a[6];
+    x1r = a[7] + a[4];
+    x1i = a[6] - a[5];
+    x2r = a[4];
+    x2i = a[5];
+    a[8] = x2r + a[6];
+    a[9] = x2i + a[7];
+    a[12] = a[7] - x2i;
+    a[13] = x2r - a[6];
+    a[10] = wk1r * (x0r - x0i);
+    a[11] = wk1r * (x0r + x0i);
+    a[14] = wk1r * (x1i - x1r);
+    a[15] = wk1r * (x1i + x1r);
+    x0r = a[0] + a[2];
+    x0i = a[1] + a[3];
+    x1r = a[0] - a[2];
+    x1i = a[1] - a[3];
+    x2r = a[0] - a[3];
+    x2i = a[1] + a[2];
+    a[6] = a[0] + a[3];
+    a[7] = a[1] - a[2];
+    a[0] = x0r;
+    a[1] = x0i;
+    a[4] = x1r;
+    a[5] = x1i;
+    a[2] = x2r;
+    a[3] = x2i;
+}
+
+
+void cftfsubpruned(int n, double *a, double *w)
+{
+    /* Same as cftfsub(), but using cft1stpruned() (n >= 16) */
+    void cft1stpruned(int n, double *a, double *w);
+    void cftmdl(int n, int l, double *a, double *w);
+    int j, j1, j2, j3, l;
+    double x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+    
+    cft1stpruned(n, a, w);
+    l = 8;
+    while ((l << 2) < n) {
+        cftmdl(n, l, a, w);
+        l <<= 2;
+    }
+    if ((l << 2) == n) {
+        for (j = 0; j < l; j += 2) {
+            j1 = j + l;
+            j2 = j1 + l;
+            j3 = j2 + l;
+            x0r = a[j] + a[j1];
+            x0i = a[j + 1] + a[j1 + 1];
+            x1r = a[j] - a[j1];
+            x1i = a[j + 1] - a[j1 + 1];
+            x2r = a[j2] + a[j3];
+            x2i = a[j2 + 1] + a[j3 + 1];
+            x3r = a[j2] - a[j3];
+            x3i = a[j2 + 1] - a[j3 + 1];
+            a[j] = x0r + x2r;
+            a[j + 1] = x0i + x2i;
+            a[j2] = x0r - x2r;
+            a[j2 + 1] = x0i - x2i;
+            a[j1] = x1r - x3i;
+            a[j1 + 1] = x1i + x3r;
+            a[j3] = x1r + x3i;
+            a[j3 + 1] = x1i - x3r;
+        }
+    } else {
+        for (j = 0; j < l; j += 2) {
+            j1 = j + l;
+            x0r = a[j] - a[j1];
+            x0i = a[j + 1] - a[j1 + 1];
+            a[j] += a[j1];
+            a[j + 1] += a[j1 + 1];
+            a[j1] = x0r;
+            a[j1 + 1] = x0i;
+        }
+    }
+}
+
+
 void cftmdl(int n, int l, double *a, double *w)
 {
     int j, j1, j2, j3, k, k1, k2, m, m2;
@@ -28,24 +28,59 @@
 
 typedef struct FFT4gStruct {
 	int n, maxN;
+	// Number of radices of the mixed-radix plan, used when n is not a power of 2,
+	// or when the Stockham engine is selected (0 when Ooura's routines are used)
+	int radixCount;
+	// Engine used when n is a power of 2 (see fftChangeEngine()), along with the
+	// work area provided by the caller for the Stockham engine (and for the
+	// multithreaded transforms, see fftSetThreadCount())
+	int engine;
+	double* scratch;
+	// 0 when FFTEngineAuto measured that splitting the transform among threads is
+	// slower for the current n (see fftSetThreadCount())
+	int threads;
 	// According to the spec: length of ip >= 2+sqrt(n/2)
-	// Since MaximumFilterLength = 8192, length of ip >= 2+sqrt(8192/2) = 66
-	int ip[70];
-	// 70 + 2 = 72
-	// 72 * 4 bytes = 288 bytes = 100100000 (w is aligned in a 32-byte boundary)
-	double w[0];
+	// (or >= 2+sqrt(n) for the complex transform used by fftPair())
+	// ip is allocated right after the structure (see fftSizeOf()), with a length that
+	// depends on n, which goes up to MaximumFFTLength (when n is not a power of 2, the
+	// mixed-radix plan is stored there instead, see fft4g.c)
+	// The cos/sin table (w) is shared by all instances (see fft4g.c/fft4gf.c)
+	int ip[0];
 } FFT4g;
 
 typedef struct FFT4gfStruct {
 	int n, maxN;
+	// Number of radices of the mixed-radix plan, used when n is not a power of 2,
+	// or when the Stockham engine is selected (0 when Ooura's routines are used)
+	int radixCount;
+	// Engine used when n is a power of 2 (see fftChangeEngine()), along with the
+	// work area provided by the caller for the Stockham engine (and for the
+	// multithreaded transforms, see fftSetThreadCount())
+	int engine;
+	float* scratch;
+	// 0 when FFTEngineAuto measured that splitting the transform among threads is
+	// slower for the current n (see fftSetThreadCount())
+	int threads;
 	// According to the spec: length of ip >= 2+sqrt(n/2)
-	// Since MaximumFilterLength = 8192, length of ip >= 2+sqrt(8192/2) = 66
-	int ip[70];
-	// 70 + 2 = 72
-	// 72 * 4 bytes = 288 bytes = 100100000 (w is aligned in a 32-byte boundary)
-	float w[0];
+	// (or >= 2+sqrt(n) for the complex transform used by fftPair())
+	// ip is allocated right after the structure (see fftSizeOf()), with a length that
+	// depends on n, which goes up to MaximumFFTLength (when n is not a power of 2, the
+	// mixed-radix plan is stored there instead, see fft4g.c)
+	// The cos/sin table (w) is shared by all instances (see fft4g.c/fft4gf.c)
+	int ip[0];
 } FFT4gf;
 
+// Fixed-point (Q15) complex transform, with block floating-point scaling, used by the
+// analyzers, which only display the spectrum (n must be a power of 2, between 16 and
+// 65536). The structure is followed by the twiddle factors of every stage, and by
+// the bit reversal permutation of n (see fftq15.c). It only pays off when
+// FFT_SIMD_Q15 is defined (see simd.h), as its scalar version, a plain radix-2
+// algorithm, is several times slower than fftPairPrunedf().
+typedef struct FFTQ15Struct {
+	int n;
+	short table[0];
+} FFTQ15;
+
 extern size_t fftSizeOf(int n);
 extern FFT4g* fftInit(FFT4g* fft4g, int n);
 extern FFT4g* fftAlloc(int n);
@@ -58,6 +93,61 @@ extern FFT4gf* fftAllocf(int n);
 extern void fftFreef(FFT4gf* fft4gf);
 extern void fftChangeNf(FFT4gf* fft4gf, int n);
 
+extern size_t fftSizeOfq15(int n);
+extern FFTQ15* fftInitq15(FFTQ15* fftq15, int n);
+extern FFTQ15* fftAllocq15(int n);
+extern void fftFreeq15(FFTQ15* fftq15);
+
+// Engines used when n is a power of 2 (when n is not a power of 2, the Stockham
+// algorithm is always used, with a work area allocated along with the structure)
+// FFTEngineOoura: Ooura's in-place routines (default)
+// FFTEngineStockham: self-sorting Stockham algorithm, with unit-stride accesses and
+// no bit reversal passes, which ping-pongs between data and the work area provided
+// by the caller (scratch must hold at least fftScratchSizeOf(maxN) bytes, and
+// belongs to the caller, who must keep it alive while the engine is in use)
+// The output of both engines is the same (within rounding errors), ordered as
+// described below. fftChangeEngine() returns 0 when engine is invalid, or when
+// scratch is null for FFTEngineStockham/FFTEngineAuto (scratch is optional for
+// FFTEngineOoura, and is only used by the multithreaded transforms, see
+// fftSetThreadCount()). fftPruned()/fftPairPruned() do not skip
+// anything when the Stockham engine is used (the upper half is just cleared).
+// FFTEngineAuto: the planner measures both engines above (for the current n, and
+// again whenever fftChangeN() changes it), and picks the fastest one, unless the
+// wisdom already holds a choice for that n and precision (scratch is required, as
+// the Stockham engine could be chosen). When there is more than one thread, the
+// planner also measures FFTEngineOoura with the large transforms split among them,
+// and only splits them when that is faster.
+#define FFTEngineOoura 0
+#define FFTEngineStockham 1
+#define FFTEngineAuto 2
+extern size_t fftScratchSizeOf(int n);
+extern int fftChangeEngine(FFT4g* fft4g, int engine, double* scratch);
+extern size_t fftScratchSizeOff(int n);
+extern int fftChangeEnginef(FFT4gf* fft4gf, int engine, float* scratch);
+
+// Wisdom: the choices made by FFTEngineAuto so far, for each power of 2, which can
+// be saved (exported to a blob of FFTWisdomSize bytes) and loaded again later, so
+// that the next time the planner does not need to measure anything. Only entries
+// present in the blob are replaced by fftImportWisdom(), which returns 0 when the
+// blob is invalid (or was exported by an incompatible version).
+#define FFTWisdomSize 20
+extern void fftExportWisdom(unsigned char* blob);
+extern int fftImportWisdom(const unsigned char* blob);
+extern void fftExportWisdomf(unsigned char* blob);
+extern int fftImportWisdomf(const unsigned char* blob);
+
+// Large transforms (fft()/ffti()/fftf()/fftif() of 16384 points or more, using
+// FFTEngineOoura, by instances that have a work area, see fftChangeEngine()) are
+// split among threadCount threads (the caller included). fftSetThreadCount() creates
+// (or destroys) the threads, and returns how many threads are actually available,
+// which is always 1 unless the library is built with FFT_THREADS and pthreads (see
+// Makefile), and never more than the number of logical cores (the split transform
+// is slower than the regular one when the threads have to share a core). It must
+// not be called while a transform is running, and transforms that use threads must
+// not be called by more than one thread at a time.
+#define FFTMaximumThreadCount 16
+extern int fftSetThreadCount(int threadCount);
+
 // Ordering of data
 // time [0]          | Real [bin 0]
 // time [1]          | Real [bin n / 2]
@@ -67,8 +157,63 @@ extern void fftChangeNf(FFT4gf* fft4gf, int n);
 // time [...]        | Imag [bin ...]
 // time [n - 2]      | Real [bin (n / 2) - 1]
 // time [n - 1]      | Imag [bin (n / 2) - 1]
+//
+// n does not need to be a power of 2 (see fftMixedInit() in fft4g.c), but, when n
+// is odd, there is no bin n / 2, and the ordering becomes
+// time [0]          | Real [bin 0]
+// time [1]          | Real [bin 1]
+// time [2]          | Imag [bin 1]
+// time [...]        | Real [bin ...]
+// time [...]        | Imag [bin ...]
+// time [n - 2]      | Real [bin (n - 1) / 2]
+// time [n - 1]      | Imag [bin (n - 1) / 2]
 
 extern void fft(FFT4g* fft4g, double* data);
 extern void ffti(FFT4g* fft4g, double* data);
 extern void fftf(FFT4gf* fft4gf, float* data);
 extern void fftif(FFT4gf* fft4gf, float* data);
+
+// Two real signals, x and y, of length n are transformed at once, by a single
+// complex transform of n points (the length of data is 2 * n)
+// Input (time domain):
+// data [2 * i]      | x [i]
+// data [2 * i + 1]  | y [i]
+// Output (frequency domain):
+// data [0...n-1]    | X, ordered as described above
+// data [n...2n-1]   | Y, ordered as described above
+// fftPairi()/fftPairif() perform the opposite conversion. The first call made by
+// an instance may have to grow the shared cos/sin table, as the complex transform
+// requires a table twice as large as the one required by fft()/fftf().
+extern void fftPair(FFT4g* fft4g, double* data);
+extern void fftPairi(FFT4g* fft4g, double* data);
+extern void fftPairf(FFT4gf* fft4gf, float* data);
+extern void fftPairif(FFT4gf* fft4gf, float* data);
+
+// Same as fft()/fftf() and fftPair()/fftPairf(), but data is assumed to be
+// zero-padded: data [n/2...n-1] (fftPruned()) or data [2*(n/2)...2n-1]
+// (fftPairPruned(), meaning x [n/2...n-1] and y [n/2...n-1], which is
+// data [n...2n-1] when n is even) are never read, and need not be cleared
+// beforehand. The butterflies of the first stage, which would only combine
+// zeroes, are skipped (only when n is a power of 2, other lengths fall back to
+// the regular transform).
+extern void fftPruned(FFT4g* fft4g, double* data);
+extern void fftPairPruned(FFT4g* fft4g, double* data);
+extern void fftPrunedf(FFT4gf* fft4gf, float* data);
+extern void fftPairPrunedf(FFT4gf* fft4gf, float* data);
+
+// Same as fftPruned()/fftPrunedf(), but only bins 0...binCount-1 are guaranteed to be
+// computed (data [1], the Nyquist bin, is only valid when binCount > n/2). When only a
+// handful of bins are necessary, they are computed by a Goertzel bank, instead of the
+// whole transform, whichever is cheaper for the current n.
+extern void fftPrunedBins(FFT4g* fft4g, double* data, int binCount);
+extern void fftPrunedBinsf(FFT4gf* fft4gf, float* data, int binCount);
+
+// Same as fftPairPruned(), but in Q15: x [0...n/2-1] and y [0...n/2-1] must lie within
+// +-32767 (data [n...2n-1] is never read). The values are halved before the stages
+// that could overflow, and the returned exponent tells how many times that happened,
+// meaning the actual spectrum is the output multiplied by 2^exponent. The output is
+// left in bit reversed order, and it is not split into X and Y, as
+// fftPairMagnitudesq15() takes care of that, storing |X [k]| at x [k] and |Y [k]| at
+// y [k], for k = 0...binCount-1 (binCount <= (n/2)+1), already scaled by 2^exponent.
+extern int fftPairPrunedq15(const FFTQ15* fftq15, short* data);
+extern void fftPairMagnitudesq15(const FFTQ15* fftq15, const short* data, int exponent, float* x, float* y, int binCount);
@@ -44,30 +44,820 @@
 // https://www.jjj.de/fft/fftpage.html
 //
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#endif
 #include <stdlib.h>
 #include <memory.h>
+#include <math.h>
 #include "fft4g.h"
+#include "fftThreads.h"
+#include "simd.h"
 
+void cdftf(int n, int isgn, float *a, int *ip, float *w);
+void bitrv2f(int n, int *ip, float *a);
+void cftfsubprunedf(int n, float *a, float *w);
+void rftfsubf(int n, float *a, int nc, float *c);
 void rdftf(int n, int isgn, float *a, int *ip, float *w);
+void makewtf(int nw, int *ip, float *w);
+void makectf(int nc, int *ip, float *c);
+
+// The cos/sin table is shared by all FFT4gf instances. It is built only once, for the
+// largest n requested so far, and, since Ooura's routines accept tables built for a
+// larger n, it is reused for every smaller power of 2. This means instances only
+// hold the bit reversal work area (ip[2...]), which rdftf() overwrites every time.
+static float* sharedWf;
+static int sharedNwf, sharedNcf;
+
+// The exact bound, for the complex transform of n points used by fftPairf(), is
+// 2+(1<<(int)(log(n+0.5)/log(2))/2), which is also enough for rdftf() of n points
+static int fftIpLengthf(int n) {
+	int bits = 0;
+	while ((1 << bits) < n)
+		bits++;
+	return 2 + (1 << (bits >> 1));
+}
+
+static int fftPrepareSharedTablef(int n) {
+	// According to the spec: length of w = n / 2
+	if (sharedWf && n <= (sharedNwf << 2))
+		return 1;
+	float* const w = (float*)malloc(sizeof(float) * (n / 2));
+	if (!w)
+		return 0;
+	// makewtf() uses ip[2...] as work area
+	int* const ip = (int*)malloc(sizeof(int) * fftIpLengthf(n));
+	if (!ip) {
+		free(w);
+		return 0;
+	}
+	const int nw = n >> 2;
+	makewtf(nw, ip, w);
+	makectf(nw, ip, w + nw);
+	free(ip);
+	if (sharedWf)
+		free(sharedWf);
+	sharedWf = w;
+	sharedNwf = nw;
+	sharedNcf = nw;
+	return 1;
+}
+
+// When n is not a power of 2, Ooura's routines cannot be used, and a mixed-radix plan
+// is built instead (radices 4, 2, 3, 5 and any other prime, in this order). The area
+// right after the structure holds the radices of n / 2 (or of n, when n is odd),
+// followed by the table of e^(i.2.pi.k/n), for k = 0...n-1, and by the work area. The
+// transforms are computed by the self-sorting Stockham algorithm, ping-ponging
+// between data and the work area. When n is even, the real transform of n points is
+// computed by a complex transform of n / 2 points (just like rdftf() does).
+#define FFTMixedRadixCount 32
+
+// Goertzel is only worth it for a handful of bins (see fftPrunedBinsf())
+#define FFTGoertzelMaxBins 32
+// fftPrunedf() costs about as much as (log2(n) * FFTGoertzelCostMul / FFTGoertzelCostDiv)
+// bins computed by fftGoertzelf() (measured natively, the SIMD transform being much
+// cheaper than the scalar one)
+#ifdef FFT_SIMD
+#define FFTGoertzelCostMul 1
+#define FFTGoertzelCostDiv 3
+#else
+#define FFTGoertzelCostMul 4
+#define FFTGoertzelCostDiv 5
+#endif
+
+// When the Stockham engine is selected for a power of 2 (see fftChangeEnginef()), the
+// radices of n / 2 are stored in ip (which is only used as a work area by Ooura's
+// routines), the table of e^(i.2.pi.k/N), for k = 0...N-1, is shared by all instances
+// (N being the largest power of 2 requested so far, so the table is also valid for
+// any smaller power of 2, with a stride of N / n), and the work area is provided by
+// the caller.
+static float* sharedStockhamTablef;
+static int sharedStockhamNf;
+
+static int fftPrepareSharedStockhamTablef(int n) {
+	if (sharedStockhamTablef && n <= sharedStockhamNf)
+		return 1;
+	float* const table = (float*)malloc(sizeof(float) * (n << 1));
+	if (!table)
+		return 0;
+	const double _2_PI_N = (2.0 * 3.1415926535897932384626433832795) / (double)n;
+	for (int k = 0; k < n; k++) {
+		table[(k << 1)] = (float)cos(_2_PI_N * (double)k);
+		table[(k << 1) + 1] = (float)sin(_2_PI_N * (double)k);
+	}
+	if (sharedStockhamTablef)
+		free(sharedStockhamTablef);
+	sharedStockhamTablef = table;
+	sharedStockhamNf = n;
+	return 1;
+}
+
+static float* fftMixedTablef(FFT4gf* fft4gf) {
+	// The table is aligned on a 16-byte boundary
+	return (float*)(((size_t)(fft4gf->ip + FFTMixedRadixCount) + 15) & ~(size_t)15);
+}
+
+static size_t fftMixedSizeOff(int n) {
+	// Table (2n) + work area (2n, or 4n when n is odd, since the real input must be
+	// extended to a complex one)
+	return sizeof(FFT4gf) + (sizeof(int) * FFTMixedRadixCount) + 15 + (sizeof(float) * ((n & 1) ? (6 * n) : (4 * n)));
+}
+
+static int fftMixedFactorf(int n, int* radices) {
+	int count = 0;
+	while (!(n & 3)) {
+		radices[count++] = 4;
+		n >>= 2;
+	}
+	if (!(n & 1)) {
+		radices[count++] = 2;
+		n >>= 1;
+	}
+	for (int p = 3; n > 1; p += 2) {
+		// n is prime
+		if (p * p > n)
+			p = n;
+		while (!(n % p)) {
+			radices[count++] = p;
+			n /= p;
+		}
+	}
+	return count;
+}
+
+static void fftMixedInitf(FFT4gf* fft4gf, int n) {
+	fft4gf->radixCount = fftMixedFactorf((n & 1) ? n : (n >> 1), fft4gf->ip);
+	float* const table = fftMixedTablef(fft4gf);
+	const double _2_PI_N = (2.0 * 3.1415926535897932384626433832795) / (double)n;
+	for (int k = 0; k < n; k++) {
+		table[(k << 1)] = (float)cos(_2_PI_N * (double)k);
+		table[(k << 1) + 1] = (float)sin(_2_PI_N * (double)k);
+	}
+}
+
+// In all stages below, the current transform has radix * m points, and there are s of
+// them (interleaved), so the input of the current butterfly is x[q + s * (p + t * m)]
+// (t = 0...radix-1), and its output goes to y[q + s * ((p * radix) + u)] (u =
+// 0...radix-1), after being multiplied by e^(isgn.i.2.pi.p.u/(radix * m)), which is
+// table[p * u * ts] (ts = s * the stride of the table). Only q = q0...s-1 are processed.
+
+static void fftMixedRadix2f(int m, int s, int q0, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1;
+		const float w1r = table[k1], w1i = isgn * table[k1 + 1];
+		for (int q = q0; q < s; q++) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * (p << 1))) << 1);
+			const float x1r = a[0] - a[d], x1i = a[1] - a[d + 1];
+			b[0] = a[0] + a[d];
+			b[1] = a[1] + a[d + 1];
+			b[(s << 1)] = (w1r * x1r) - (w1i * x1i);
+			b[(s << 1) + 1] = (w1r * x1i) + (w1i * x1r);
+		}
+	}
+}
+
+static void fftMixedRadix3f(int m, int s, int q0, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1;
+	// sin(2 * pi / 3)
+	const float sn = isgn * 0.86602540378443864676372317075294f;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1;
+		const float w1r = table[k1], w1i = isgn * table[k1 + 1];
+		const float w2r = table[k2], w2i = isgn * table[k2 + 1];
+		for (int q = q0; q < s; q++) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * p * 3)) << 1);
+			const float t1r = a[d] + a[(d << 1)], t1i = a[d + 1] + a[(d << 1) + 1];
+			const float t2r = a[0] - (0.5f * t1r), t2i = a[1] - (0.5f * t1i);
+			const float t3r = sn * (a[d] - a[(d << 1)]), t3i = sn * (a[d + 1] - a[(d << 1) + 1]);
+			// b1 = t2 + i.t3, b2 = t2 - i.t3
+			const float b1r = t2r - t3i, b1i = t2i + t3r;
+			const float b2r = t2r + t3i, b2i = t2i - t3r;
+			b[0] = a[0] + t1r;
+			b[1] = a[1] + t1i;
+			b[(s << 1)] = (w1r * b1r) - (w1i * b1i);
+			b[(s << 1) + 1] = (w1r * b1i) + (w1i * b1r);
+			b[(s << 2)] = (w2r * b2r) - (w2i * b2i);
+			b[(s << 2) + 1] = (w2r * b2i) + (w2i * b2r);
+		}
+	}
+}
+
+static void fftMixedRadix4f(int m, int s, int q0, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1, s2 = s << 1;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1, k3 = k1 + k2;
+		const float w1r = table[k1], w1i = isgn * table[k1 + 1];
+		const float w2r = table[k2], w2i = isgn * table[k2 + 1];
+		const float w3r = table[k3], w3i = isgn * table[k3 + 1];
+		for (int q = q0; q < s; q++) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * (p << 2))) << 1);
+			const float a1r = a[d], a1i = a[d + 1];
+			const float a2r = a[(d << 1)], a2i = a[(d << 1) + 1];
+			const float a3r = a[(d << 1) + d], a3i = a[(d << 1) + d + 1];
+			const float t0r = a[0] + a2r, t0i = a[1] + a2i;
+			const float t1r = a[0] - a2r, t1i = a[1] - a2i;
+			const float t2r = a1r + a3r, t2i = a1i + a3i;
+			// isgn.i.(a1 - a3)
+			const float t3r = isgn * (a3i - a1i), t3i = isgn * (a1r - a3r);
+			const float b1r = t1r + t3r, b1i = t1i + t3i;
+			const float b2r = t0r - t2r, b2i = t0i - t2i;
+			const float b3r = t1r - t3r, b3i = t1i - t3i;
+			b[0] = t0r + t2r;
+			b[1] = t0i + t2i;
+			b[s2] = (w1r * b1r) - (w1i * b1i);
+			b[s2 + 1] = (w1r * b1i) + (w1i * b1r);
+			b[(s2 << 1)] = (w2r * b2r) - (w2i * b2i);
+			b[(s2 << 1) + 1] = (w2r * b2i) + (w2i * b2r);
+			b[(s2 << 1) + s2] = (w3r * b3r) - (w3i * b3i);
+			b[(s2 << 1) + s2 + 1] = (w3r * b3i) + (w3i * b3r);
+		}
+	}
+}
+
+static void fftMixedRadix5f(int m, int s, int q0, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1, s2 = s << 1;
+	// cos(2 * pi / 5), cos(4 * pi / 5), sin(2 * pi / 5) and sin(4 * pi / 5)
+	const float c1 = 0.30901699437494742410229341718282f;
+	const float c2 = -0.80901699437494742410229341718282f;
+	const float s1 = isgn * 0.95105651629515357211643933337938f;
+	const float s2n = isgn * 0.58778525229247312916870595463907f;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1, k3 = k1 + k2, k4 = k2 << 1;
+		const float w1r = table[k1], w1i = isgn * table[k1 + 1];
+		const float w2r = table[k2], w2i = isgn * table[k2 + 1];
+		const float w3r = table[k3], w3i = isgn * table[k3 + 1];
+		const float w4r = table[k4], w4i = isgn * table[k4 + 1];
+		for (int q = q0; q < s; q++) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * p * 5)) << 1);
+			const float a1r = a[d], a1i = a[d + 1];
+			const float a2r = a[(d << 1)], a2i = a[(d << 1) + 1];
+			const float a3r = a[(d << 1) + d], a3i = a[(d << 1) + d + 1];
+			const float a4r = a[(d << 2)], a4i = a[(d << 2) + 1];
+			const float t1r = a1r + a4r, t1i = a1i + a4i;
+			const float t2r = a2r + a3r, t2i = a2i + a3i;
+			const float t3r = a1r - a4r, t3i = a1i - a4i;
+			const float t4r = a2r - a3r, t4i = a2i - a3i;
+			const float e1r = a[0] + (c1 * t1r) + (c2 * t2r), e1i = a[1] + (c1 * t1i) + (c2 * t2i);
+			const float e2r = a[0] + (c2 * t1r) + (c1 * t2r), e2i = a[1] + (c2 * t1i) + (c1 * t2i);
+			const float o1r = (s1 * t3r) + (s2n * t4r), o1i = (s1 * t3i) + (s2n * t4i);
+			const float o2r = (s2n * t3r) - (s1 * t4r), o2i = (s2n * t3i) - (s1 * t4i);
+			// b1 = e1 + i.o1, b4 = e1 - i.o1, b2 = e2 + i.o2, b3 = e2 - i.o2
+			const float b1r = e1r - o1i, b1i = e1i + o1r;
+			const float b4r = e1r + o1i, b4i = e1i - o1r;
+			const float b2r = e2r - o2i, b2i = e2i + o2r;
+			const float b3r = e2r + o2i, b3i = e2i - o2r;
+			b[0] = a[0] + t1r + t2r;
+			b[1] = a[1] + t1i + t2i;
+			b[s2] = (w1r * b1r) - (w1i * b1i);
+			b[s2 + 1] = (w1r * b1i) + (w1i * b1r);
+			b[(s2 << 1)] = (w2r * b2r) - (w2i * b2i);
+			b[(s2 << 1) + 1] = (w2r * b2i) + (w2i * b2r);
+			b[(s2 << 1) + s2] = (w3r * b3r) - (w3i * b3i);
+			b[(s2 << 1) + s2 + 1] = (w3r * b3i) + (w3i * b3r);
+			b[(s2 << 2)] = (w4r * b4r) - (w4i * b4i);
+			b[(s2 << 2) + 1] = (w4r * b4i) + (w4i * b4r);
+		}
+	}
+}
+
+static void fftMixedRadixGenericf(int radix, int m, int s, int q0, int ts, int isgn, const float* x, float* y, const float* table) {
+	// radix is an odd prime, so t and radix - t are processed together, as are u and
+	// radix - u:
+	// b[u] = a[0] + sum(c[t.u].(a[t] + a[radix - t]) + i.s[t.u].(a[t] - a[radix - t]))
+	// b[radix - u] = a[0] + sum(c[t.u].(a[t] + a[radix - t]) - i.s[t.u].(a[t] - a[radix - t]))
+	const int d = (s * m) << 1, s2 = s << 1, half = radix >> 1;
+	// e^(isgn.i.2.pi.j/radix) = table[j * m * ts]
+	const int rts = m * ts;
+	for (int p = 0; p < m; p++) {
+		for (int q = q0; q < s; q++) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * p * radix)) << 1);
+			float b0r = a[0], b0i = a[1];
+			for (int t = 1; t <= half; t++) {
+				b0r += a[t * d] + a[(radix - t) * d];
+				b0i += a[(t * d) + 1] + a[((radix - t) * d) + 1];
+			}
+			b[0] = b0r;
+			b[1] = b0i;
+			for (int u = 1; u <= half; u++) {
+				float er = a[0], ei = a[1], or = 0, oi = 0;
+				// j = (t * u) % radix
+				for (int t = 1, j = u; t <= half; t++) {
+					const float* const at = a + (t * d);
+					const float* const ant = a + ((radix - t) * d);
+					const int k = (j * rts) << 1;
+					const float c = table[k], sn = isgn * table[k + 1];
+					er += c * (at[0] + ant[0]);
+					ei += c * (at[1] + ant[1]);
+					or += sn * (at[0] - ant[0]);
+					oi += sn * (at[1] - ant[1]);
+					j += u;
+					if (j >= radix)
+						j -= radix;
+				}
+				const float bur = er - oi, bui = ei + or;
+				const float bvr = er + oi, bvi = ei - or;
+				const int ku = (p * u * ts) << 1, kv = (p * (radix - u) * ts) << 1;
+				const float wur = table[ku], wui = isgn * table[ku + 1];
+				const float wvr = table[kv], wvi = isgn * table[kv + 1];
+				b[u * s2] = (wur * bur) - (wui * bui);
+				b[(u * s2) + 1] = (wur * bui) + (wui * bur);
+				b[(radix - u) * s2] = (wvr * bvr) - (wvi * bvi);
+				b[((radix - u) * s2) + 1] = (wvr * bvi) + (wvi * bvr);
+			}
+		}
+	}
+}
+
+#ifdef FFT_SIMD
+// SIMD versions of the stages above, which process q and q + 1 at once (both use the
+// same twiddle factors). They process q = 0...(s & ~1)-1, leaving the last q, when s
+// is odd, to the scalar stages.
+
+static void fftMixedRadix2fSimd(int m, int s, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1, qe = s & ~1;
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1;
+		const simdf w1r = simdSet1(table[k1]), w1i = simdSet1(isgn * table[k1 + 1]);
+		for (int q = 0; q < qe; q += 2) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * (p << 1))) << 1);
+			const simdf a0 = simdLoad(a), a1 = simdLoad(a + d);
+			simdStore(b, simdAdd(a0, a1));
+			simdStore(b + (s << 1), simdCMul(simdSub(a0, a1), w1r, w1i));
+		}
+	}
+}
+
+static void fftMixedRadix3fSimd(int m, int s, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1, qe = s & ~1;
+	const simdf half = simdSet1(0.5f);
+	// sin(2 * pi / 3)
+	const simdf sn = simdSet1(isgn * 0.86602540378443864676372317075294f);
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1;
+		const simdf w1r = simdSet1(table[k1]), w1i = simdSet1(isgn * table[k1 + 1]);
+		const simdf w2r = simdSet1(table[k2]), w2i = simdSet1(isgn * table[k2 + 1]);
+		for (int q = 0; q < qe; q += 2) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * p * 3)) << 1);
+			const simdf a0 = simdLoad(a), a1 = simdLoad(a + d), a2 = simdLoad(a + (d << 1));
+			const simdf t1 = simdAdd(a1, a2);
+			const simdf t2 = simdSub(a0, simdMul(half, t1));
+			const simdf t3 = simdMulI(simdMul(sn, simdSub(a1, a2)));
+			simdStore(b, simdAdd(a0, t1));
+			simdStore(b + (s << 1), simdCMul(simdAdd(t2, t3), w1r, w1i));
+			simdStore(b + (s << 2), simdCMul(simdSub(t2, t3), w2r, w2i));
+		}
+	}
+}
+
+static void fftMixedRadix4fSimd(int m, int s, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1, s2 = s << 1, qe = s & ~1;
+	const simdf sgn = simdSet1((float)isgn);
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1, k3 = k1 + k2;
+		const simdf w1r = simdSet1(table[k1]), w1i = simdSet1(isgn * table[k1 + 1]);
+		const simdf w2r = simdSet1(table[k2]), w2i = simdSet1(isgn * table[k2 + 1]);
+		const simdf w3r = simdSet1(table[k3]), w3i = simdSet1(isgn * table[k3 + 1]);
+		for (int q = 0; q < qe; q += 2) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * (p << 2))) << 1);
+			const simdf a0 = simdLoad(a), a1 = simdLoad(a + d), a2 = simdLoad(a + (d << 1)), a3 = simdLoad(a + (d << 1) + d);
+			const simdf t0 = simdAdd(a0, a2), t1 = simdSub(a0, a2), t2 = simdAdd(a1, a3);
+			// isgn.i.(a1 - a3)
+			const simdf t3 = simdMul(sgn, simdMulI(simdSub(a1, a3)));
+			simdStore(b, simdAdd(t0, t2));
+			simdStore(b + s2, simdCMul(simdAdd(t1, t3), w1r, w1i));
+			simdStore(b + (s2 << 1), simdCMul(simdSub(t0, t2), w2r, w2i));
+			simdStore(b + (s2 << 1) + s2, simdCMul(simdSub(t1, t3), w3r, w3i));
+		}
+	}
+}
+
+static void fftMixedRadix5fSimd(int m, int s, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1, s2 = s << 1, qe = s & ~1;
+	// cos(2 * pi / 5), cos(4 * pi / 5), sin(2 * pi / 5) and sin(4 * pi / 5)
+	const simdf c1 = simdSet1(0.30901699437494742410229341718282f);
+	const simdf c2 = simdSet1(-0.80901699437494742410229341718282f);
+	const simdf s1 = simdSet1(isgn * 0.95105651629515357211643933337938f);
+	const simdf s2n = simdSet1(isgn * 0.58778525229247312916870595463907f);
+	for (int p = 0; p < m; p++) {
+		const int k1 = (p * ts) << 1, k2 = k1 << 1, k3 = k1 + k2, k4 = k2 << 1;
+		const simdf w1r = simdSet1(table[k1]), w1i = simdSet1(isgn * table[k1 + 1]);
+		const simdf w2r = simdSet1(table[k2]), w2i = simdSet1(isgn * table[k2 + 1]);
+		const simdf w3r = simdSet1(table[k3]), w3i = simdSet1(isgn * table[k3 + 1]);
+		const simdf w4r = simdSet1(table[k4]), w4i = simdSet1(isgn * table[k4 + 1]);
+		for (int q = 0; q < qe; q += 2) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * p * 5)) << 1);
+			const simdf a0 = simdLoad(a), a1 = simdLoad(a + d), a2 = simdLoad(a + (d << 1)), a3 = simdLoad(a + (d << 1) + d), a4 = simdLoad(a + (d << 2));
+			const simdf t1 = simdAdd(a1, a4), t2 = simdAdd(a2, a3);
+			const simdf t3 = simdSub(a1, a4), t4 = simdSub(a2, a3);
+			const simdf e1 = simdAdd(a0, simdAdd(simdMul(c1, t1), simdMul(c2, t2)));
+			const simdf e2 = simdAdd(a0, simdAdd(simdMul(c2, t1), simdMul(c1, t2)));
+			const simdf o1 = simdMulI(simdAdd(simdMul(s1, t3), simdMul(s2n, t4)));
+			const simdf o2 = simdMulI(simdSub(simdMul(s2n, t3), simdMul(s1, t4)));
+			simdStore(b, simdAdd(a0, simdAdd(t1, t2)));
+			simdStore(b + s2, simdCMul(simdAdd(e1, o1), w1r, w1i));
+			simdStore(b + (s2 << 1), simdCMul(simdAdd(e2, o2), w2r, w2i));
+			simdStore(b + (s2 << 1) + s2, simdCMul(simdSub(e2, o2), w3r, w3i));
+			simdStore(b + (s2 << 2), simdCMul(simdSub(e1, o1), w4r, w4i));
+		}
+	}
+}
+
+static void fftMixedRadixGenericfSimd(int radix, int m, int s, int ts, int isgn, const float* x, float* y, const float* table) {
+	const int d = (s * m) << 1, s2 = s << 1, qe = s & ~1, half = radix >> 1;
+	const int rts = m * ts;
+	for (int p = 0; p < m; p++) {
+		for (int q = 0; q < qe; q += 2) {
+			const float* const a = x + ((q + (s * p)) << 1);
+			float* const b = y + ((q + (s * p * radix)) << 1);
+			const simdf a0 = simdLoad(a);
+			simdf b0 = a0;
+			for (int t = 1; t <= half; t++)
+				b0 = simdAdd(b0, simdAdd(simdLoad(a + (t * d)), simdLoad(a + ((radix - t) * d))));
+			simdStore(b, b0);
+			for (int u = 1; u <= half; u++) {
+				simdf e = a0, o = simdSet1(0);
+				for (int t = 1, j = u; t <= half; t++) {
+					const simdf at = simdLoad(a + (t * d)), ant = simdLoad(a + ((radix - t) * d));
+					const int k = (j * rts) << 1;
+					e = simdAdd(e, simdMul(simdSet1(table[k]), simdAdd(at, ant)));
+					o = simdAdd(o, simdMul(simdSet1(isgn * table[k + 1]), simdSub(at, ant)));
+					j += u;
+					if (j >= radix)
+						j -= radix;
+				}
+				o = simdMulI(o);
+				const int ku = (p * u * ts) << 1, kv = (p * (radix - u) * ts) << 1;
+				simdStore(b + (u * s2), simdCMul(simdAdd(e, o), simdSet1(table[ku]), simdSet1(isgn * table[ku + 1])));
+				simdStore(b + ((radix - u) * s2), simdCMul(simdSub(e, o), simdSet1(table[kv]), simdSet1(isgn * table[kv + 1])));
+			}
+		}
+	}
+}
+
+static int fftMixedStagefSimd(int radix, int m, int s, int ts, int isgn, const float* x, float* y, const float* table) {
+	switch (radix) {
+	case 2:
+		fftMixedRadix2fSimd(m, s, ts, isgn, x, y, table);
+		break;
+	case 3:
+		fftMixedRadix3fSimd(m, s, ts, isgn, x, y, table);
+		break;
+	case 4:
+		fftMixedRadix4fSimd(m, s, ts, isgn, x, y, table);
+		break;
+	case 5:
+		fftMixedRadix5fSimd(m, s, ts, isgn, x, y, table);
+		break;
+	default:
+		fftMixedRadixGenericfSimd(radix, m, s, ts, isgn, x, y, table);
+		break;
+	}
+	return s & ~1;
+}
+#endif
+
+// Complex transform of m points (m = the product of all radices), using
+// table[tstride * k] as e^(i.2.pi.k/m). Returns either a or b, whichever holds the
+// result (the other one is destroyed).
+static float* fftMixedComplexf(const int* radices, int radixCount, int m, int isgn, float* a, float* b, const float* table, int tstride) {
+	float* x = a;
+	float* y = b;
+	for (int r = 0, s = 1; r < radixCount; r++) {
+		const int radix = radices[r];
+		m /= radix;
+		int q0 = 0;
+#ifdef FFT_SIMD
+		if (s >= 2)
+			q0 = fftMixedStagefSimd(radix, m, s, s * tstride, isgn, x, y, table);
+#endif
+		switch (radix) {
+		case 2:
+			fftMixedRadix2f(m, s, q0, s * tstride, isgn, x, y, table);
+			break;
+		case 3:
+			fftMixedRadix3f(m, s, q0, s * tstride, isgn, x, y, table);
+			break;
+		case 4:
+			fftMixedRadix4f(m, s, q0, s * tstride, isgn, x, y, table);
+			break;
+		case 5:
+			fftMixedRadix5f(m, s, q0, s * tstride, isgn, x, y, table);
+			break;
+		default:
+			fftMixedRadixGenericf(radix, m, s, q0, s * tstride, isgn, x, y, table);
+			break;
+		}
+		s *= radix;
+		float* const t = x;
+		x = y;
+		y = t;
+	}
+	return x;
+}
+
+// Returns the stride of the table, whose entries are e^(i.2.pi.k/n)
+static int fftMixedBuffersf(FFT4gf* fft4gf, const float** table, float** work) {
+	const int n = fft4gf->n;
+	if ((n & (n - 1))) {
+		*table = fftMixedTablef(fft4gf);
+		*work = (float*)*table + (n << 1);
+		return 1;
+	}
+	*table = sharedStockhamTablef;
+	*work = fft4gf->scratch;
+	return sharedStockhamNf / n;
+}
+
+// z[j] = x[2j] + i.x[2j+1], Z = DFT(z), h = n / 2
+// X[k] = E[k] + w^k.O[k], X[h - k] = conj(E[k] - w^k.O[k])
+// E[k] = (Z[k] + conj(Z[h - k])) / 2
+// O[k] = (Z[k] - conj(Z[h - k])) / 2i
+// Both functions below handle k = first...last (and h - k), and accept the same
+// buffer as input and output, as k and h - k are always read before being written
+static void fftRealSplitf(int n, const float* z, float* data, const float* table, int tstride, int first, int last) {
+	for (int k = first; k <= last; k++) {
+		const int j = k << 1, j2 = n - j;
+		const float wr = table[j * tstride], wi = table[(j * tstride) + 1];
+		const float zkr = z[j], zki = z[j + 1], zhkr = z[j2], zhki = z[j2 + 1];
+		const float ekr = 0.5f * (zkr + zhkr), eki = 0.5f * (zki - zhki);
+		const float okr = 0.5f * (zki + zhki), oki = 0.5f * (zhkr - zkr);
+		const float wokr = (wr * okr) - (wi * oki), woki = (wr * oki) + (wi * okr);
+		data[j] = ekr + wokr;
+		data[j + 1] = eki + woki;
+		data[j2] = ekr - wokr;
+		data[j2 + 1] = woki - eki;
+	}
+}
+
+// The opposite of fftRealSplitf(), from the spectrum (data) back to Z
+static void fftRealJoinf(int n, const float* data, float* z, const float* table, int tstride, int first, int last) {
+	for (int k = first; k <= last; k++) {
+		const int j = k << 1, j2 = n - j;
+		const float wr = table[j * tstride], wi = table[(j * tstride) + 1];
+		const float xkr = data[j], xki = data[j + 1], xhkr = data[j2], xhki = data[j2 + 1];
+		const float ekr = 0.5f * (xkr + xhkr), eki = 0.5f * (xki - xhki);
+		// O[k] = (X[k] - conj(X[h - k])) . conj(w^k) / 2
+		const float dr = 0.5f * (xkr - xhkr), di = 0.5f * (xki + xhki);
+		const float okr = (wr * dr) + (wi * di), oki = (wr * di) - (wi * dr);
+		// Z[k] = E[k] + i.O[k], Z[h - k] = conj(E[k]) + i.conj(O[k])
+		z[j] = ekr - oki;
+		z[j + 1] = eki + okr;
+		z[j2] = ekr + oki;
+		z[j2 + 1] = okr - eki;
+	}
+}
+
+// Same scaling and ordering used by rdftf() (see fft4g.h for the ordering used
+// when n is odd)
+static void fftMixedRealf(FFT4gf* fft4gf, int isgn, float* data) {
+	const int n = fft4gf->n;
+	const float* table;
+	float* work;
+	// table[tstride * k] = e^(i.2.pi.k/n)
+	const int tstride = fftMixedBuffersf(fft4gf, &table, &work);
+
+	if ((n & 1)) {
+		// The input is extended to a complex one, and the transform of n points is computed
+		if (isgn >= 0) {
+			for (int j = 0; j < n; j++) {
+				work[(j << 1)] = data[j];
+				work[(j << 1) + 1] = 0;
+			}
+			const float* const z = fftMixedComplexf(fft4gf->ip, fft4gf->radixCount, n, 1, work, work + (n << 1), table, tstride);
+			data[0] = z[0];
+			for (int k = 1; k < n; k += 2) {
+				data[k] = z[k + 1];
+				data[k + 1] = z[k + 2];
+			}
+		} else {
+			// The output must be scaled by n / 2 (just like rdftf()), therefore the
+			// spectrum is scaled by 1 / 2
+			work[0] = 0.5f * data[0];
+			work[1] = 0;
+			for (int k = 1; k < n; k += 2) {
+				const int j = (n << 1) - k - 1;
+				work[k + 1] = 0.5f * data[k];
+				work[k + 2] = 0.5f * data[k + 1];
+				work[j] = 0.5f * data[k];
+				work[j + 1] = -0.5f * data[k + 1];
+			}
+			const float* const z = fftMixedComplexf(fft4gf->ip, fft4gf->radixCount, n, -1, work, work + (n << 1), table, tstride);
+			for (int j = 0; j < n; j++)
+				data[j] = z[j << 1];
+		}
+		return;
+	}
+
+	// z[j] = x[2j] + i.x[2j+1], Z = DFT(z), h = n / 2 (see fftRealSplitf())
+	const int h = n >> 1;
+	if (isgn >= 0) {
+		const float* const z = fftMixedComplexf(fft4gf->ip, fft4gf->radixCount, h, 1, data, work, table, tstride << 1);
+		const float z0r = z[0], z0i = z[1];
+		fftRealSplitf(n, z, data, table, tstride, 1, h >> 1);
+		data[0] = z0r + z0i;
+		data[1] = z0r - z0i;
+	} else {
+		const float x0 = data[0], xh = data[1];
+		fftRealJoinf(n, data, data, table, tstride, 1, h >> 1);
+		data[0] = 0.5f * (x0 + xh);
+		data[1] = 0.5f * (x0 - xh);
+		const float* const z = fftMixedComplexf(fft4gf->ip, fft4gf->radixCount, h, -1, data, work, table, tstride << 1);
+		if (z != data)
+			memcpy(data, z, sizeof(float) * n);
+	}
+}
+
+// Same as fftPairf(), but for the mixed-radix plan (without the final scaling)
+static void fftMixedPairf(FFT4gf* fft4gf, int isgn, float* data) {
+	const int n = fft4gf->n, n2 = n << 1;
+	const float* table;
+	float* work;
+	const int tstride = fftMixedBuffersf(fft4gf, &table, &work);
+	// The radices of n, instead of those of n / 2
+	int radices[FFTMixedRadixCount];
+	int radixCount = fft4gf->radixCount;
+	memcpy(radices, fft4gf->ip, sizeof(int) * radixCount);
+	if (!(n & 1))
+		radices[radixCount++] = 2;
+	// When n is odd, X[k] goes to data[2k - 1] and data[2k], instead of data[2k] and data[2k + 1]
+	const int odd = (n & 1), last = ((n - 1) >> 1);
+
+	if (isgn >= 0) {
+		float* z = fftMixedComplexf(radices, radixCount, n, 1, data, work, table, tstride);
+		if (z == data) {
+			memcpy(work, data, sizeof(float) * n2);
+			z = work;
+		}
+		// X[k] = (Z[k] + conj(Z[n - k])) / 2
+		// Y[k] = (Z[k] - conj(Z[n - k])) / 2i
+		float* const y = data + n;
+		data[0] = z[0];
+		y[0] = z[1];
+		if (!odd) {
+			data[1] = z[n];
+			y[1] = z[n + 1];
+		}
+		for (int k = 1; k <= last; k++) {
+			const int j = k << 1, j2 = n2 - j, o = j - odd;
+			data[o] = 0.5f * (z[j] + z[j2]);
+			data[o + 1] = 0.5f * (z[j + 1] - z[j2 + 1]);
+			y[o] = 0.5f * (z[j + 1] + z[j2 + 1]);
+			y[o + 1] = 0.5f * (z[j2] - z[j]);
+		}
+	} else {
+		// Z[k] = X[k] + i.Y[k] and Z[n - k] = conj(X[k]) + i.conj(Y[k])
+		const float* const y = data + n;
+		work[0] = data[0];
+		work[1] = y[0];
+		if (!odd) {
+			work[n] = data[1];
+			work[n + 1] = y[1];
+		}
+		for (int k = 1; k <= last; k++) {
+			const int j = k << 1, j2 = n2 - j, o = j - odd;
+			work[j] = data[o] - y[o + 1];
+			work[j + 1] = data[o + 1] + y[o];
+			work[j2] = data[o] + y[o + 1];
+			work[j2 + 1] = y[o] - data[o + 1];
+		}
+		const float* const z = fftMixedComplexf(radices, radixCount, n, -1, work, data, table, tstride);
+		if (z != data)
+			memcpy(data, z, sizeof(float) * n2);
+	}
+}
+
+// The planner runs each engine on about FFTPlannerWork / log2(n) points per trial
+// (long enough for the coarse timers provided by some browsers), and keeps the
+// fastest of FFTPlannerTrials trials. Below FFTPlannerMinimumN, the transforms are
+// so short that the call overhead dominates, and Ooura's routines are just used.
+#define FFTPlannerWork (1 << 20)
+#define FFTPlannerTrials 3
+#define FFTPlannerMinimumN 64
+#define FFTWisdomVersion 2
+// Only used by the planner and by the wisdom: FFTEngineOoura, with the large transforms
+// split among threads (see fftThreadsUsablef()), which is only worth it when there are
+// enough cores (the four-step decomposition is slower than rdft() on a single one)
+#define FFTEngineOouraThreads 3
+
+// Engine chosen by FFTEngineAuto for each power of 2, indexed by log2(n): 0 when n
+// has not been measured yet, or engine + 1 (FFTEngineOouraThreads included, which
+// reflects the thread count at the time of the measurement) (see fftExportWisdomf())
+static unsigned char wisdomf[FFTWisdomSize - 1];
+
+static int fftPrepareEnginef(FFT4gf* fft4gf, int n);
+static int fftThreadsUsablef(FFT4gf* fft4gf);
+
+static int fftMeasureEnginef(FFT4gf* fft4gf, int n) {
+	int log2n = 0;
+	while ((1 << log2n) < n)
+		log2n++;
+	if (wisdomf[log2n])
+		return wisdomf[log2n] - 1;
+	if (n < FFTPlannerMinimumN)
+		return FFTEngineOoura;
+
+	float* const data = (float*)malloc(sizeof(float) * n);
+	if (!data)
+		return FFTEngineOoura;
+	for (int i = 0; i < n; i++)
+		data[i] = (float)((i & 15) - 8);
+
+	// fftf() and fftif() are called in turns, so that data never overflows
+	const int oldN = fft4gf->n;
+	const int repetitions = 1 + (FFTPlannerWork / (n * (log2n + 1)));
+	int bestEngine = FFTEngineOoura;
+	// -1 means no measurement yet (a coarse timer may legitimately report 0)
+	double bestTime = -1;
+	fft4gf->n = n;
+	static const int engines[] = { FFTEngineOoura, FFTEngineStockham, FFTEngineOouraThreads };
+	for (int e = 0; e < 3; e++) {
+		const int engine = engines[e];
+		fft4gf->engine = ((engine == FFTEngineOouraThreads) ? FFTEngineOoura : engine);
+		if (!fftPrepareEnginef(fft4gf, n))
+			continue;
+		// Threads are measured separately, and only when they would actually be used
+		fft4gf->threads = (engine == FFTEngineOouraThreads);
+		if (engine == FFTEngineOouraThreads && !fftThreadsUsablef(fft4gf))
+			continue;
+		fftf(fft4gf, data);
+		fftif(fft4gf, data);
+		for (int t = 0; t < FFTPlannerTrials; t++) {
+			const double start = emscripten_get_now();
+			for (int r = 0; r < repetitions; r++) {
+				fftf(fft4gf, data);
+				fftif(fft4gf, data);
+			}
+			const double time = emscripten_get_now() - start;
+			if (bestTime < 0 || time < bestTime) {
+				bestTime = time;
+				bestEngine = engine;
+			}
+		}
+	}
+	fft4gf->n = oldN;
+	fft4gf->engine = FFTEngineAuto;
+	free(data);
+
+	wisdomf[log2n] = (unsigned char)(bestEngine + 1);
+	return bestEngine;
+}
+
+// Only for powers of 2
+static int fftPrepareEnginef(FFT4gf* fft4gf, int n) {
+	int engine = fft4gf->engine;
+	// The threads are always allowed when the engine is chosen by the caller
+	fft4gf->threads = 1;
+	if (engine == FFTEngineAuto) {
+		engine = fftMeasureEnginef(fft4gf, n);
+		fft4gf->threads = (engine == FFTEngineOouraThreads);
+		if (engine == FFTEngineOouraThreads)
+			engine = FFTEngineOoura;
+	}
+	if (engine == FFTEngineStockham) {
+		if (!fftPrepareSharedStockhamTablef(n))
+			return 0;
+		fft4gf->radixCount = fftMixedFactorf(n >> 1, fft4gf->ip);
+	} else {
+		fft4gf->radixCount = 0;
+	}
+	return 1;
+}
 
 size_t fftSizeOff(int n) {
-    // According to the spec: length of w = n / 2
-	return sizeof(FFT4gf) + (sizeof(float) * (n / 2));
+	return ((n & (n - 1)) ? fftMixedSizeOff(n) : (sizeof(FFT4gf) + (sizeof(int) * fftIpLengthf(n))));
 }
 
 FFT4gf* fftInitf(FFT4gf* fft4gf, int n) {
-    if (n > MaximumFilterLength)
-        return 0;
+	// The shared table is only used when n is a power of 2
+	if (n < 2 || n > MaximumFFTLength || (!(n & (n - 1)) && !fftPrepareSharedTablef(n)))
+		return 0;
 	memset(fft4gf, 0, fftSizeOff(n));
 	fft4gf->n = n;
-    fft4gf->maxN = n;
+	fft4gf->maxN = n;
+	if ((n & (n - 1)))
+		fftMixedInitf(fft4gf, n);
 	return fft4gf;
 }
 
 FFT4gf* fftAllocf(int n) {
-    // n must be a power of 2
-	return (((n & (n - 1)) || (n > MaximumFilterLength)) ? 0 : fftInitf((FFT4gf*)malloc(fftSizeOff(n)), n));
+	if (n < 2 || n > MaximumFFTLength)
+		return 0;
+	FFT4gf* const fft4gf = (FFT4gf*)malloc(fftSizeOff(n));
+	if (fft4gf && !fftInitf(fft4gf, n)) {
+		free(fft4gf);
+		return 0;
+	}
+	return fft4gf;
 }
 
 void fftFreef(FFT4gf* fft4gf) {
@@ -76,23 +866,414 @@ void fftFreef(FFT4gf* fft4gf) {
 }
 
 void fftChangeNf(FFT4gf* fft4gf, int n) {
-    // n must be a power of 2
-    if ((n & (n - 1)) || n > fft4gf->maxN)
-        return;
-    fft4gf->n = n;
-    fft4gf->ip[0] = 0;
-    fft4gf->ip[1] = 0;
+	// n must fit in the area allocated for maxN
+	if (n < 2 || n > fft4gf->maxN || n == fft4gf->n || fftSizeOff(n) > fftSizeOff(fft4gf->maxN))
+		return;
+	if ((n & (n - 1))) {
+		fftMixedInitf(fft4gf, n);
+	} else {
+		// The shared table was built for maxN or larger, unless maxN is not a power of 2
+		if (!fftPrepareSharedTablef(n) || !fftPrepareEnginef(fft4gf, n))
+			return;
+	}
+	fft4gf->n = n;
+}
+
+size_t fftScratchSizeOff(int n) {
+	return sizeof(float) * (n << 1);
+}
+
+int fftChangeEnginef(FFT4gf* fft4gf, int engine, float* scratch) {
+	if (engine < FFTEngineOoura || engine > FFTEngineAuto || (engine != FFTEngineOoura && !scratch))
+		return 0;
+	// Plans for lengths that are not powers of 2 always use the Stockham algorithm,
+	// with their own work area
+	const int n = fft4gf->n, oldEngine = fft4gf->engine;
+	float* const oldScratch = fft4gf->scratch;
+	fft4gf->engine = engine;
+	fft4gf->scratch = scratch;
+	if (!(n & (n - 1)) && !fftPrepareEnginef(fft4gf, n)) {
+		fft4gf->engine = oldEngine;
+		fft4gf->scratch = oldScratch;
+		return 0;
+	}
+	return 1;
+}
+
+void fftExportWisdomf(unsigned char* blob) {
+	blob[0] = FFTWisdomVersion;
+	memcpy(blob + 1, wisdomf, FFTWisdomSize - 1);
+}
+
+int fftImportWisdomf(const unsigned char* blob) {
+	if (blob[0] != FFTWisdomVersion)
+		return 0;
+	for (int i = 1; i < FFTWisdomSize; i++) {
+		if (blob[i] > (FFTEngineOouraThreads + 1))
+			return 0;
+	}
+	// Only the entries already measured by the blob are replaced
+	for (int i = 1; i < FFTWisdomSize; i++) {
+		if (blob[i])
+			wisdomf[i - 1] = blob[i];
+	}
+	return 1;
+}
+
+static void fftPrepareIpf(FFT4gf* fft4gf) {
+	// Another instance could have made the shared table grow since the last call
+	fft4gf->ip[0] = sharedNwf;
+	fft4gf->ip[1] = sharedNcf;
+}
+
+// Transforms of FFTThreadsMinimumN points or more are split among all threads (see
+// fftSetThreadCount()), when the instance has a work area, by a four-step
+// decomposition of the complex transform of m = n / 2 points used by rdftf(): z is
+// seen as a matrix of r rows and c columns (z[(c * j1) + j2], r <= c, both powers of
+// 2), whose columns are transformed first (and then multiplied by
+// e^(i.2.pi.j2.k1/m)), followed by its rows, which leaves Z[k1 + (r * k2)] at
+// z[(c * k1) + k2]. Every thread transforms a range of columns/rows, by calling
+// cdftf() with its own bit reversal work area, and the rows are transposed into the
+// work area, right after being transformed (the inverse transform does everything
+// in the opposite order). There are three steps, with all threads in sync between
+// them, whose scaling and ordering are the same used by fftMixedRealf().
+#define FFTThreadsMinimumN 16384
+// Columns are gathered/scattered in groups, so that all values read from a cache line
+// are used at once (fftThreadsColumnsf() requires count * FFTThreadsColumnGroup <= c,
+// which holds for any n >= 8192 when count <= FFTMaximumThreadCount)
+#define FFTThreadsColumnGroup 4
+// Long enough for the longest row (c <= 512, as MaximumFFTLength is 262144)
+#define FFTThreadsIpLength (2 + 32)
+
+typedef struct FFTThreadsJobfStruct {
+	int n, r, c, isgn;
+	// table[tstride * k] = e^(i.2.pi.k/n)
+	int tstride;
+	float* data;
+	float* work;
+	const float* table;
+} FFTThreadsJobf;
+
+static void fftThreadsColumnsf(void* context, int index, int count) {
+	const FFTThreadsJobf* const job = (const FFTThreadsJobf*)context;
+	const int r = job->r, c = job->c, r2 = r << 1, c2 = c << 1, isgn = job->isgn, tstride = job->tstride << 2;
+	const float* const table = job->table;
+	// The columns are in data during the forward transform, or in the first half of
+	// the work area during the inverse transform (the second half holds the columns
+	// gathered by each thread)
+	float* const a = ((isgn >= 0) ? job->data : job->work);
+	float* const buffer = job->work + job->n + (index * FFTThreadsColumnGroup * r2);
+	int ip[FFTThreadsIpLength];
+	ip[0] = sharedNwf;
+	ip[1] = sharedNcf;
+
+	const int groupCount = c / FFTThreadsColumnGroup;
+	for (int g = (groupCount * index) / count, lastG = (groupCount * (index + 1)) / count; g < lastG; g++) {
+		const int j2 = g * FFTThreadsColumnGroup;
+		for (int j1 = 0; j1 < r; j1++) {
+			const float* const src = a + (j1 * c2) + (j2 << 1);
+			for (int i = 0; i < FFTThreadsColumnGroup; i++) {
+				buffer[(i * r2) + (j1 << 1)] = src[(i << 1)];
+				buffer[(i * r2) + (j1 << 1) + 1] = src[(i << 1) + 1];
+			}
+		}
+		for (int i = 0; i < FFTThreadsColumnGroup; i++) {
+			float* const column = buffer + (i * r2);
+			cdftf(r2, isgn, column, ip, sharedWf);
+			// column[k1] *= e^(isgn.i.2.pi.j2.k1/m), and j2.k1 < m
+			for (int k1 = 1; k1 < r; k1++) {
+				const float* const w = table + ((j2 + i) * k1 * tstride);
+				const float wr = w[0], wi = ((isgn >= 0) ? w[1] : -w[1]);
+				const float xr = column[(k1 << 1)], xi = column[(k1 << 1) + 1];
+				column[(k1 << 1)] = (xr * wr) - (xi * wi);
+				column[(k1 << 1) + 1] = (xr * wi) + (xi * wr);
+			}
+		}
+		for (int k1 = 0; k1 < r; k1++) {
+			float* const dst = a + (k1 * c2) + (j2 << 1);
+			for (int i = 0; i < FFTThreadsColumnGroup; i++) {
+				dst[(i << 1)] = buffer[(i * r2) + (k1 << 1)];
+				dst[(i << 1) + 1] = buffer[(i * r2) + (k1 << 1) + 1];
+			}
+		}
+	}
+}
+
+static void fftThreadsRowsf(void* context, int index, int count) {
+	const FFTThreadsJobf* const job = (const FFTThreadsJobf*)context;
+	const int r = job->r, c = job->c, r2 = r << 1, c2 = c << 1, isgn = job->isgn;
+	// Rows are transformed in place and transposed into the other buffer
+	float* const a = ((isgn >= 0) ? job->data : job->work);
+	float* const b = ((isgn >= 0) ? job->work : job->data);
+	int ip[FFTThreadsIpLength];
+	ip[0] = sharedNwf;
+	ip[1] = sharedNcf;
+
+	for (int k1 = (r * index) / count, lastK1 = (r * (index + 1)) / count; k1 < lastK1; k1++) {
+		float* const row = a + (k1 * c2);
+		cdftf(c2, isgn, row, ip, sharedWf);
+		float* const dst = b + (k1 << 1);
+		for (int k2 = 0; k2 < c; k2++) {
+			dst[k2 * r2] = row[(k2 << 1)];
+			dst[(k2 * r2) + 1] = row[(k2 << 1) + 1];
+		}
+	}
+}
+
+static void fftThreadsSplitf(void* context, int index, int count) {
+	const FFTThreadsJobf* const job = (const FFTThreadsJobf*)context;
+	const int n = job->n, h2 = n >> 2;
+	// k = 1...h/2 (k = 0 is handled by the caller)
+	const int first = 1 + ((h2 * index) / count), last = (h2 * (index + 1)) / count;
+	if (job->isgn >= 0)
+		fftRealSplitf(n, job->work, job->data, job->table, job->tstride, first, last);
+	else
+		fftRealJoinf(n, job->data, job->work, job->table, job->tstride, first, last);
+}
+
+static int fftThreadsUsablef(FFT4gf* fft4gf) {
+	const int n = fft4gf->n;
+	// The table of e^(i.2.pi.k/n) is the one used by the Stockham engine
+	return (n >= FFTThreadsMinimumN && fft4gf->threads && fft4gf->scratch && !fft4gf->radixCount && fftThreadsCount() > 1 && fftPrepareSharedStockhamTablef(n));
+}
+
+static void fftThreadsRealf(FFT4gf* fft4gf, int isgn, float* data) {
+	const int n = fft4gf->n, m = n >> 1;
+	int log2m = 0;
+	while ((1 << log2m) < m)
+		log2m++;
+	FFTThreadsJobf job;
+	job.n = n;
+	job.r = 1 << (log2m >> 1);
+	job.c = m >> (log2m >> 1);
+	job.isgn = isgn;
+	job.tstride = sharedStockhamNf / n;
+	job.data = data;
+	job.work = fft4gf->scratch;
+	job.table = sharedStockhamTablef;
+	float* const z = job.work;
+
+	if (isgn >= 0) {
+		fftThreadsRun(fftThreadsColumnsf, &job);
+		fftThreadsRun(fftThreadsRowsf, &job);
+		fftThreadsRun(fftThreadsSplitf, &job);
+		data[0] = z[0] + z[1];
+		data[1] = z[0] - z[1];
+	} else {
+		z[0] = 0.5f * (data[0] + data[1]);
+		z[1] = 0.5f * (data[0] - data[1]);
+		fftThreadsRun(fftThreadsSplitf, &job);
+		fftThreadsRun(fftThreadsColumnsf, &job);
+		fftThreadsRun(fftThreadsRowsf, &job);
+	}
 }
 
 void fftf(FFT4gf* fft4gf, float* data) {
-	rdftf(fft4gf->n, 1, data, fft4gf->ip, fft4gf->w);
+	if (fft4gf->radixCount) {
+		fftMixedRealf(fft4gf, 1, data);
+		return;
+	}
+	if (fftThreadsUsablef(fft4gf)) {
+		fftThreadsRealf(fft4gf, 1, data);
+		return;
+	}
+	fftPrepareIpf(fft4gf);
+	rdftf(fft4gf->n, 1, data, fft4gf->ip, sharedWf);
 }
 
 void fftif(FFT4gf* fft4gf, float* data) {
-	rdftf(fft4gf->n, -1, data, fft4gf->ip, fft4gf->w);
-    const float _2_N = 2.0f / (float)fft4gf->n;
-    for (int i = fft4gf->n - 1; i >= 0; i--)
-        data[i] *= _2_N;
+	if (fft4gf->radixCount) {
+		fftMixedRealf(fft4gf, -1, data);
+	} else if (fftThreadsUsablef(fft4gf)) {
+		fftThreadsRealf(fft4gf, -1, data);
+	} else {
+		fftPrepareIpf(fft4gf);
+		rdftf(fft4gf->n, -1, data, fft4gf->ip, sharedWf);
+	}
+	const float _2_N = 2.0f / (float)fft4gf->n;
+	for (int i = fft4gf->n - 1; i >= 0; i--)
+		data[i] *= _2_N;
+}
+
+static void fftPairSplitf(int n, float* data) {
+	// Z[k] = X[k] + i.Y[k], and since x and y are real:
+	// X[k] = (Z[k] + conj(Z[n - k])) / 2
+	// Y[k] = (Z[k] - conj(Z[n - k])) / 2i
+	// X[k] is stored where Z[k] was, and Y[k] where Z[n/2 + k] was, so k and n/2 - k
+	// are processed together, as they read and write the same four positions:
+	// k, n - k, n/2 - k and n/2 + k
+	const float t = data[1];
+	data[1] = data[n];
+	data[n] = t;
+	for (int k = (n >> 2); k >= 1; k--) {
+		const int j = k << 1, jn = n - j, jn2 = n + j, j2 = (n << 1) - j;
+		const float zkr = data[j], zki = data[j + 1];
+		const float znkr = data[j2], znki = data[j2 + 1];
+		const float zn2kr = data[jn], zn2ki = data[jn + 1];
+		const float zn2pkr = data[jn2], zn2pki = data[jn2 + 1];
+		// X[k] and Y[k]
+		data[j] = 0.5f * (zkr + znkr);
+		data[j + 1] = 0.5f * (zki - znki);
+		data[jn2] = 0.5f * (zki + znki);
+		data[jn2 + 1] = 0.5f * (znkr - zkr);
+		// X[n/2 - k] and Y[n/2 - k]
+		data[jn] = 0.5f * (zn2kr + zn2pkr);
+		data[jn + 1] = 0.5f * (zn2ki - zn2pki);
+		data[j2] = 0.5f * (zn2ki + zn2pki);
+		data[j2 + 1] = 0.5f * (zn2pkr - zn2kr);
+	}
+}
+
+void fftPairf(FFT4gf* fft4gf, float* data) {
+	if (fft4gf->radixCount) {
+		fftMixedPairf(fft4gf, 1, data);
+		return;
+	}
+	const int n = fft4gf->n;
+	// The complex transform of n points requires a table twice as large as the one
+	// required by the real transform of n points
+	if (!fftPrepareSharedTablef(n << 1))
+		return;
+	fftPrepareIpf(fft4gf);
+	cdftf(n << 1, 1, data, fft4gf->ip, sharedWf);
+	fftPairSplitf(n, data);
+}
+
+void fftPairif(FFT4gf* fft4gf, float* data) {
+	const int n = fft4gf->n;
+	if (fft4gf->radixCount) {
+		fftMixedPairf(fft4gf, -1, data);
+	} else {
+		if (!fftPrepareSharedTablef(n << 1))
+			return;
+
+		// Z[k] = X[k] + i.Y[k] and Z[n - k] = conj(X[k]) + i.conj(Y[k]), using the same
+		// positions used by fftPairf()
+		const float t = data[1];
+		data[1] = data[n];
+		data[n] = t;
+		for (int k = (n >> 2); k >= 1; k--) {
+			const int j = k << 1, jn = n - j, jn2 = n + j, j2 = (n << 1) - j;
+			const float xkr = data[j], xki = data[j + 1];
+			const float ykr = data[jn2], yki = data[jn2 + 1];
+			const float xn2kr = data[jn], xn2ki = data[jn + 1];
+			const float yn2kr = data[j2], yn2ki = data[j2 + 1];
+			// Z[k] and Z[n - k]
+			data[j] = xkr - yki;
+			data[j + 1] = xki + ykr;
+			data[j2] = xkr + yki;
+			data[j2 + 1] = ykr - xki;
+			// Z[n/2 - k] and Z[n/2 + k]
+			data[jn] = xn2kr - yn2ki;
+			data[jn + 1] = xn2ki + yn2kr;
+			data[jn2] = xn2kr + yn2ki;
+			data[jn2 + 1] = yn2kr - xn2ki;
+		}
+
+		fftPrepareIpf(fft4gf);
+		cdftf(n << 1, -1, data, fft4gf->ip, sharedWf);
+	}
+	const float _1_N = 1.0f / (float)n;
+	for (int i = (n << 1) - 1; i >= 0; i--)
+		data[i] *= _1_N;
+}
+
+void fftPrunedf(FFT4gf* fft4gf, float* data) {
+	const int n = fft4gf->n;
+	// The mixed-radix plans and the small sizes just clear the upper half
+	if (fft4gf->radixCount || n < 16) {
+		// When n is odd, the upper half has one more element than the lower one
+		memset(data + (n >> 1), 0, sizeof(float) * (n - (n >> 1)));
+		fftf(fft4gf, data);
+		return;
+	}
+	fftPrepareIpf(fft4gf);
+	// Same as rdftf(n, 1, ...), but only the lower half goes through the bit reversal
+	bitrv2f(n >> 1, fft4gf->ip + 2, data);
+	cftfsubprunedf(n, data, sharedWf);
+	rftfsubf(n, data, sharedNcf, sharedWf + sharedNwf);
+	const float xi = data[0] - data[1];
+	data[0] += data[1];
+	data[1] = xi;
+}
+
+void fftPairPrunedf(FFT4gf* fft4gf, float* data) {
+	const int n = fft4gf->n;
+	if (fft4gf->radixCount || n < 8) {
+		// x [n/2] and y [n/2] start at 2 * (n/2), which is n - 1 when n is odd
+		memset(data + ((n >> 1) << 1), 0, sizeof(float) * ((n << 1) - ((n >> 1) << 1)));
+		fftPairf(fft4gf, data);
+		return;
+	}
+	if (!fftPrepareSharedTablef(n << 1))
+		return;
+	fftPrepareIpf(fft4gf);
+	// Same as cdftf(2n, 1, ...), but only the lower half goes through the bit reversal
+	bitrv2f(n, fft4gf->ip + 2, data);
+	cftfsubprunedf(n << 1, data, sharedWf);
+	fftPairSplitf(n, data);
+}
+
+static int fftPrunedBinsUseGoertzelf(int n, int binCount) {
+	if (binCount > FFTGoertzelMaxBins || binCount > (n >> 1))
+		return 0;
+	// Rough cost model: each bin costs n/2 iterations of the Goertzel recurrence
+	// (bins are computed in groups of 4), while the cost of the transform grows with
+	// n * log2(n)
+	int log2n = 0;
+	while ((1 << log2n) < n)
+		log2n++;
+	return ((((binCount + 3) & ~3) * FFTGoertzelCostDiv) <= (log2n * FFTGoertzelCostMul));
+}
+
+static void fftGoertzelf(int n, int binCount, float* data) {
+	// Only data [0...n/2-1] is read (the rest is assumed to be zero). The recurrence
+	// runs backwards (Clenshaw), so that sum(x [j] * e^(i*w*j)) = b0 - (e^(-i*w) * b1).
+	// Four bins are computed at a time, to break the dependency chain of the recurrence
+	// (the extra bins of the last group are computed and thrown away). The recurrence
+	// is always computed in double precision, as it loses too much precision in float
+	// at low frequencies.
+	float bins[FFTGoertzelMaxBins << 1];
+	const int m = n >> 1;
+	const double w = 6.283185307179586476925286766559 / (double)n;
+	for (int k = 0; k < binCount; k += 4) {
+		const double c0 = 2.0 * cos(w * (double)k), c1 = 2.0 * cos(w * (double)(k + 1)),
+			c2 = 2.0 * cos(w * (double)(k + 2)), c3 = 2.0 * cos(w * (double)(k + 3));
+		double a0 = 0, a1 = 0, a2 = 0, a3 = 0, b0 = 0, b1 = 0, b2 = 0, b3 = 0, t;
+		for (int j = m - 1; j >= 0; j--) {
+			const double x = (double)data[j];
+			t = a0; a0 = x + (c0 * a0) - b0; b0 = t;
+			t = a1; a1 = x + (c1 * a1) - b1; b1 = t;
+			t = a2; a2 = x + (c2 * a2) - b2; b2 = t;
+			t = a3; a3 = x + (c3 * a3) - b3; b3 = t;
+		}
+		float* const bin = bins + (k << 1);
+		bin[0] = (float)(a0 - (0.5 * c0 * b0));
+		bin[1] = (float)(sin(w * (double)k) * b0);
+		if ((k + 1) < binCount) {
+			bin[2] = (float)(a1 - (0.5 * c1 * b1));
+			bin[3] = (float)(sin(w * (double)(k + 1)) * b1);
+		}
+		if ((k + 2) < binCount) {
+			bin[4] = (float)(a2 - (0.5 * c2 * b2));
+			bin[5] = (float)(sin(w * (double)(k + 2)) * b2);
+		}
+		if ((k + 3) < binCount) {
+			bin[6] = (float)(a3 - (0.5 * c3 * b3));
+			bin[7] = (float)(sin(w * (double)(k + 3)) * b3);
+		}
+	}
+	// data [1] should hold the Nyquist bin, which is not computed here (bin 0 has
+	// no imaginary part, so it is just left as 0)
+	memcpy(data, bins, sizeof(float) * (binCount << 1));
+}
+
+void fftPrunedBinsf(FFT4gf* fft4gf, float* data, int binCount) {
+	const int n = fft4gf->n;
+	if (fft4gf->radixCount || !fftPrunedBinsUseGoertzelf(n, binCount))
+		fftPrunedf(fft4gf, data);
+	else
+		fftGoertzelf(n, binCount, data);
 }
 
 /*
@@ -1018,6 +2199,13 @@ void cftfsubf(int n, float *a, float *w)
     int j, j1, j2, j3, l;
     float x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
     
+#ifdef FFT_SIMD
+    void cftfsubfSimd(int n, float *a, float *w);
+    if (n > 8) {
+        cftfsubfSimd(n, a, w);
+        return;
+    }
+#endif
     l = 2;
     if (n > 8) {
         cft1stf(n, a, w);
@@ -1070,6 +2258,13 @@ void cftbsubf(int n, float *a, float *w)
     int j, j1, j2, j3, l;
     float x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
     
+#ifdef FFT_SIMD
+    void cftbsubfSimd(int n, float *a, float *w);
+    if (n > 8) {
+        cftbsubfSimd(n, a, w);
+        return;
+    }
+#endif
     l = 2;
     if (n > 8) {
         cft1stf(n, a, w);
@@ -1220,6 +2415,155 @@ void cft1stf(int n, float *a, float *w)
 }
 
 
+void cft1stprunedf(int n, float *a, float *w)
+{
+    /*
+    Same as cft1stf(), but only a[0...n/2-1] holds data, in the order
+    left by bitrv2f(n/2), as the upper half of the original input was
+    zero. Therefore, the element at position p must go to position 2p,
+    and the odd (complex) positions are zero. The blocks are processed
+    in descending order, so that a[0...n/2-1] is consumed before being
+    overwritten, and the remaining of a[] is never read.
+    */
+    int j, k1, k2;
+    float wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
+    float x0r, x0i, x1r, x1i, x2r, x2i;
+    float *b;
+    
+    for (j = n - 16; j >= 16; j -= 16) {
+        b = a + (j >> 1);
+        k1 = j >> 3;
+        k2 = 2 * k1;
+        wk2r = w[k1];
+        wk2i = w[k1 + 1];
+        wk1r = w[k2 + 2];
+        wk1i = w[k2 + 3];
+        wk3r = wk1r - 2 * wk2r * wk1i;
+        wk3i = 2 * wk2r * wk1r - wk1i;
+        x0r = b[4] + b[6];
+        x0i = b[5] + b[7];
+        x1r = b[4] - b[6];
+        x1i = b[5] - b[7];
+        x2r = b[4] - b[7];
+        x2i = b[5] + b[6];
+        a[j + 8] = x0r;
+        a[j + 9] = x0i;
+        a[j + 12] = -wk2i * x1r - wk2r * x1i;
+        a[j + 13] = -wk2i * x1i + wk2r * x1r;
+        a[j + 10] = wk1r * x2r - wk1i * x2i;
+        a[j + 11] = wk1r * x2i + wk1i * x2r;
+        x2r = b[4] + b[7];
+        x2i = b[5] - b[6];
+        a[j + 14] = wk3r * x2r - wk3i * x2i;
+        a[j + 15] = wk3r * x2i + wk3i * x2r;
+        wk1r = w[k2];
+        wk1i = w[k2 + 1];
+        wk3r = wk1r - 2 * wk2i * wk1i;
+        wk3i = 2 * wk2i * wk1r - wk1i;
+        x0r = b[0] + b[2];
+        x0i = b[1] + b[3];
+        x1r = b[0] - b[2];
+        x1i = b[1] - b[3];
+        x2r = b[0] - b[3];
+        x2i = b[1] + b[2];
+        a[j] = x0r;
+        a[j + 1] = x0i;
+        a[j + 4] = wk2r * x1r - wk2i * x1i;
+        a[j + 5] = wk2r * x1i + wk2i * x1r;
+        a[j + 2] = wk1r * x2r - wk1i * x2i;
+        a[j + 3] = wk1r * x2i + wk1i * x2r;
+        x2r = b[0] + b[3];
+        x2i = b[1] - b[2];
+        a[j + 6] = wk3r * x2r - wk3i * x2i;
+        a[j + 7] = wk3r * x2i + wk3i * x2r;
+    }
+    wk1r = w[2];
+    x0r = a[4] - a[7];
+    x0i = a[5] + a[6];
+    x1r = a[7] + a[4];
+    x1i = a[6] - a[5];
+    x2r = a[4];
+    x2i = a[5];
+    a[8] = x2r + a[6];
+    a[9] = x2i + a[7];
+    a[12] = a[7] - x2i;
+    a[13] = x2r - a[6];
+    a[10] = wk1r * (x0r - x0i);
+    a[11] = wk1r * (x0r + x0i);
+    a[14] = wk1r * (x1i - x1r);
+    a[15] = wk1r * (x1i + x1r);
+    x0r = a[0] + a[2];
+    x0i = a[1] + a[3];
+    x1r = a[0] - a[2];
+    x1i = a[1] - a[3];
+    x2r = a[0] - a[3];
+    x2i = a[1] + a[2];
+    a[6] = a[0] + a[3];
+    a[7] = a[1] - a[2];
+    a[0] = x0r;
+    a[1] = x0i;
+    a[4] = x1r;
+    a[5] = x1i;
+    a[2] = x2r;
+    a[3] = x2i;
+}
+
+
+void cftfsubprunedf(int n, float *a, float *w)
+{
+    /* Same as cftfsubf(), but using cft1stprunedf() (n >= 16) */
+    void cft1stprunedf(int n, float *a, float *w);
+    void cftmdlf(int n, int l, float *a, float *w);
+    int j, j1, j2, j3, l;
+    float x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+    
+#ifdef FFT_SIMD
+    void cftfsubprunedfSimd(int n, float *a, float *w);
+    cftfsubprunedfSimd(n, a, w);
+    return;
+#endif
+    cft1stprunedf(n, a, w);
+    l = 8;
+    while ((l << 2) < n) {
+        cftmdlf(n, l, a, w);
+        l <<= 2;
+    }
+    if ((l << 2) == n) {
+        for (j = 0; j < l; j += 2) {
+            j1 = j + l;
+            j2 = j1 + l;
+            j3 = j2 + l;
+            x0r = a[j] + a[j1];
+            x0i = a[j + 1] + a[j1 + 1];
+            x1r = a[j] - a[j1];
+            x1i = a[j + 1] - a[j1 + 1];
+            x2r = a[j2] + a[j3];
+            x2i = a[j2 + 1] + a[j3 + 1];
+            x3r = a[j2] - a[j3];
+            x3i = a[j2 + 1] - a[j3 + 1];
+            a[j] = x0r + x2r;
+            a[j + 1] = x0i + x2i;
+            a[j2] = x0r - x2r;
+            a[j2 + 1] = x0i - x2i;
+            a[j1] = x1r - x3i;
+            a[j1 + 1] = x1i + x3r;
+            a[j3] = x1r + x3i;
+            a[j3 + 1] = x1i - x3r;
+        }
+    } else {
+        for (j = 0; j < l; j += 2) {
+            j1 = j + l;
+            x0r = a[j] - a[j1];
+            x0i = a[j + 1] - a[j1 + 1];
+            a[j] += a[j1];
+            a[j + 1] += a[j1 + 1];
+            a[j1] = x0r;
+            a[j1 + 1] = x0i;
+        }
+    }
+}
+
+
 void cftmdlf(int n, int l, float *a, float *w)
 {
     int j, j1, j2, j3, k, k1, k2, m, m2;
@@ -1352,6 +2696,13 @@ void rftfsubf(int n, float *a, int nc, float *c)
     int j, k, kk, ks, m;
     float wkr, wki, xr, xi, yr, yi;
     
+#ifdef FFT_SIMD
+    void rftfsubfSimd(int n, float *a, int nc, float *c);
+    if (n >= 16) {
+        rftfsubfSimd(n, a, nc, c);
+        return;
+    }
+#endif
     m = n >> 1;
     ks = 2 * nc / m;
     kk = 0;
@@ -1377,6 +2728,13 @@ void rftbsubf(int n, float *a, int nc, float *c)
     int j, k, kk, ks, m;
     float wkr, wki, xr, xi, yr, yi;
     
+#ifdef FFT_SIMD
+    void rftbsubfSimd(int n, float *a, int nc, float *c);
+    if (n >= 16) {
+        rftbsubfSimd(n, a, nc, c);
+        return;
+    }
+#endif
     a[1] = -a[1];
     m = n >> 1;
     ks = 2 * nc / m;
@@ -1439,3 +2797,313 @@ void dstsubf(int n, float *a, int nc, float *c)
     }
     a[m] *= c[0];
 }
+
+
+#ifdef FFT_SIMD
+
+/* -------- SIMD child routines (see simd.h) -------- */
+
+
+static void cftbfly0fSimd(int l, float *a, simdf conj)
+{
+    // Radix-4 butterflies without twiddle factors, two complex numbers at a time
+    // (conj must be either all zeroes, or the sign mask of the imaginary parts)
+    int j;
+    simdf x0, x1, x2, x3, y;
+    
+    for (j = 0; j < l; j += 4) {
+        x0 = simdLoad(a + j);
+        x1 = simdLoad(a + j + l);
+        x2 = simdLoad(a + j + 2 * l);
+        x3 = simdLoad(a + j + 3 * l);
+        y = simdAdd(x0, x1);
+        x1 = simdSub(x0, x1);
+        x0 = y;
+        y = simdAdd(x2, x3);
+        x3 = simdMulI(simdSub(x2, x3));
+        x2 = y;
+        simdStore(a + j, simdXor(simdAdd(x0, x2), conj));
+        simdStore(a + j + 2 * l, simdXor(simdSub(x0, x2), conj));
+        simdStore(a + j + l, simdXor(simdAdd(x1, x3), conj));
+        simdStore(a + j + 3 * l, simdXor(simdSub(x1, x3), conj));
+    }
+}
+
+
+static void cftbflyfSimd(int l, float *a, simdf wk1r, simdf wk1i, simdf wk2r, simdf wk2i, simdf wk3r, simdf wk3i)
+{
+    // Same as cftbfly0fSimd(), but multiplying the results by the twiddle factors
+    int j;
+    simdf x0, x1, x2, x3, y;
+    
+    for (j = 0; j < l; j += 4) {
+        x0 = simdLoad(a + j);
+        x1 = simdLoad(a + j + l);
+        x2 = simdLoad(a + j + 2 * l);
+        x3 = simdLoad(a + j + 3 * l);
+        y = simdAdd(x0, x1);
+        x1 = simdSub(x0, x1);
+        x0 = y;
+        y = simdAdd(x2, x3);
+        x3 = simdMulI(simdSub(x2, x3));
+        x2 = y;
+        simdStore(a + j, simdAdd(x0, x2));
+        simdStore(a + j + 2 * l, simdCMul(simdSub(x0, x2), wk2r, wk2i));
+        simdStore(a + j + l, simdCMul(simdAdd(x1, x3), wk1r, wk1i));
+        simdStore(a + j + 3 * l, simdCMul(simdSub(x1, x3), wk3r, wk3i));
+    }
+}
+
+
+static void cft1stblockfSimd(float *a, simdf wk1r, simdf wk1i, simdf wk2r, simdf wk2i, simdf wk3r, simdf wk3i)
+{
+    // The two radix-4 butterflies of a[0...7] and a[8...15] are computed together,
+    // the first one in the lower half of the vectors, and the second one in the upper
+    // half (that is why each half of the twiddle vectors holds a different factor)
+    simdf v0, v1, v2, v3, x0, x1, x2, x3, y;
+    
+    v0 = simdLoad(a);
+    v1 = simdLoad(a + 4);
+    v2 = simdLoad(a + 8);
+    v3 = simdLoad(a + 12);
+    x0 = simdLo(v0, v2);
+    x1 = simdHi(v0, v2);
+    x2 = simdLo(v1, v3);
+    x3 = simdHi(v1, v3);
+    y = simdAdd(x0, x1);
+    x1 = simdSub(x0, x1);
+    x0 = y;
+    y = simdAdd(x2, x3);
+    x3 = simdMulI(simdSub(x2, x3));
+    x2 = y;
+    v0 = simdAdd(x0, x2);
+    v2 = simdCMul(simdSub(x0, x2), wk2r, wk2i);
+    v1 = simdCMul(simdAdd(x1, x3), wk1r, wk1i);
+    v3 = simdCMul(simdSub(x1, x3), wk3r, wk3i);
+    simdStore(a, simdLo(v0, v1));
+    simdStore(a + 4, simdLo(v2, v3));
+    simdStore(a + 8, simdHi(v0, v1));
+    simdStore(a + 12, simdHi(v2, v3));
+}
+
+
+static void cft1stfSimd(int n, float *a, float *w)
+{
+    int j, k1, k2;
+    float wk1r, wk1i, wk2r, wk2i, wk3r, wk3i, wk1r2, wk1i2, wk3r2, wk3i2;
+    
+    wk1r = w[2];
+    cft1stblockfSimd(a,
+        simdSet(1, 1, wk1r, wk1r), simdSet(0, 0, wk1r, wk1r),
+        simdSet(1, 1, 0, 0), simdSet(0, 0, 1, 1),
+        simdSet(1, 1, -wk1r, -wk1r), simdSet(0, 0, wk1r, wk1r));
+    k1 = 0;
+    for (j = 16; j < n; j += 16) {
+        k1 += 2;
+        k2 = 2 * k1;
+        wk2r = w[k1];
+        wk2i = w[k1 + 1];
+        wk1r = w[k2];
+        wk1i = w[k2 + 1];
+        wk3r = wk1r - 2 * wk2i * wk1i;
+        wk3i = 2 * wk2i * wk1r - wk1i;
+        wk1r2 = w[k2 + 2];
+        wk1i2 = w[k2 + 3];
+        wk3r2 = wk1r2 - 2 * wk2r * wk1i2;
+        wk3i2 = 2 * wk2r * wk1r2 - wk1i2;
+        cft1stblockfSimd(a + j,
+            simdSet(wk1r, wk1r, wk1r2, wk1r2), simdSet(wk1i, wk1i, wk1i2, wk1i2),
+            simdSet(wk2r, wk2r, -wk2i, -wk2i), simdSet(wk2i, wk2i, wk2r, wk2r),
+            simdSet(wk3r, wk3r, wk3r2, wk3r2), simdSet(wk3i, wk3i, wk3i2, wk3i2));
+    }
+}
+
+
+static void cftmdlfSimd(int n, int l, float *a, float *w)
+{
+    int k, k1, k2, m, m2;
+    float wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
+    
+    m = l << 2;
+    cftbfly0fSimd(l, a, simdSet1(0));
+    wk1r = w[2];
+    cftbflyfSimd(l, a + m,
+        simdSet1(wk1r), simdSet1(wk1r),
+        simdSet1(0), simdSet1(1),
+        simdSet1(-wk1r), simdSet1(wk1r));
+    k1 = 0;
+    m2 = 2 * m;
+    for (k = m2; k < n; k += m2) {
+        k1 += 2;
+        k2 = 2 * k1;
+        wk2r = w[k1];
+        wk2i = w[k1 + 1];
+        wk1r = w[k2];
+        wk1i = w[k2 + 1];
+        wk3r = wk1r - 2 * wk2i * wk1i;
+        wk3i = 2 * wk2i * wk1r - wk1i;
+        cftbflyfSimd(l, a + k,
+            simdSet1(wk1r), simdSet1(wk1i),
+            simdSet1(wk2r), simdSet1(wk2i),
+            simdSet1(wk3r), simdSet1(wk3i));
+        wk1r = w[k2 + 2];
+        wk1i = w[k2 + 3];
+        wk3r = wk1r - 2 * wk2r * wk1i;
+        wk3i = 2 * wk2r * wk1r - wk1i;
+        cftbflyfSimd(l, a + k + m,
+            simdSet1(wk1r), simdSet1(wk1i),
+            simdSet1(-wk2i), simdSet1(wk2r),
+            simdSet1(wk3r), simdSet1(wk3i));
+    }
+}
+
+
+static void cftlastfSimd(int n, int l, float *a, simdf conj)
+{
+    int j;
+    simdf x0, x1;
+    
+    if ((l << 2) == n) {
+        cftbfly0fSimd(l, a, conj);
+    } else {
+        for (j = 0; j < l; j += 4) {
+            x0 = simdLoad(a + j);
+            x1 = simdLoad(a + j + l);
+            simdStore(a + j, simdXor(simdAdd(x0, x1), conj));
+            simdStore(a + j + l, simdXor(simdSub(x0, x1), conj));
+        }
+    }
+}
+
+
+void cftfsubprunedfSimd(int n, float *a, float *w)
+{
+    /* Same as cftfsubfSimd(), but using cft1stprunedf() (n >= 16) */
+    void cft1stprunedf(int n, float *a, float *w);
+    int l;
+    
+    cft1stprunedf(n, a, w);
+    l = 8;
+    while ((l << 2) < n) {
+        cftmdlfSimd(n, l, a, w);
+        l <<= 2;
+    }
+    cftlastfSimd(n, l, a, simdSet1(0));
+}
+void cftfsubfSimd(int n, float *a, float *w)
+{
+    // n > 8
+    int l;
+    
+    cft1stfSimd(n, a, w);
+    l = 8;
+    while ((l << 2) < n) {
+        cftmdlfSimd(n, l, a, w);
+        l <<= 2;
+    }
+    cftlastfSimd(n, l, a, simdSet1(0));
+}
+
+
+void cftbsubfSimd(int n, float *a, float *w)
+{
+    // n > 8
+    int l;
+    
+    cft1stfSimd(n, a, w);
+    l = 8;
+    while ((l << 2) < n) {
+        cftmdlfSimd(n, l, a, w);
+        l <<= 2;
+    }
+    // The last stage of cftbsubf() is the last stage of cftfsubf() with conjugated results
+    cftlastfSimd(n, l, a, simdSet(0.0f, -0.0f, 0.0f, -0.0f));
+}
+
+
+void rftfsubfSimd(int n, float *a, int nc, float *c)
+{
+    // n >= 16
+    int j, k, kk, ks, m;
+    float wkr, wki, wkr2, wki2, xr, xi, yr, yi;
+    simdf xj, xk, y;
+    
+    m = n >> 1;
+    ks = 2 * nc / m;
+    kk = 0;
+    // a[j] and a[j + 2] are processed together with a[k] and a[k - 2]
+    for (j = 2; j + 2 < m; j += 4) {
+        k = n - j;
+        kk += ks;
+        wkr = 0.5f - c[nc - kk];
+        wki = c[kk];
+        kk += ks;
+        wkr2 = 0.5f - c[nc - kk];
+        wki2 = c[kk];
+        xj = simdLoad(a + j);
+        xk = simdSwapComplex(simdLoad(a + k - 2));
+        y = simdCMul(simdSub(xj, simdNegIm(xk)), simdSet(wkr, wkr, wkr2, wkr2), simdSet(wki, wki, wki2, wki2));
+        simdStore(a + j, simdSub(xj, y));
+        simdStore(a + k - 2, simdSwapComplex(simdAdd(xk, simdNegIm(y))));
+    }
+    for (; j < m; j += 2) {
+        k = n - j;
+        kk += ks;
+        wkr = 0.5f - c[nc - kk];
+        wki = c[kk];
+        xr = a[j] - a[k];
+        xi = a[j + 1] + a[k + 1];
+        yr = wkr * xr - wki * xi;
+        yi = wkr * xi + wki * xr;
+        a[j] -= yr;
+        a[j + 1] -= yi;
+        a[k] += yr;
+        a[k + 1] -= yi;
+    }
+}
+
+
+void rftbsubfSimd(int n, float *a, int nc, float *c)
+{
+    // n >= 16
+    int j, k, kk, ks, m;
+    float wkr, wki, wkr2, wki2, xr, xi, yr, yi;
+    simdf xj, xk, y;
+    
+    a[1] = -a[1];
+    m = n >> 1;
+    ks = 2 * nc / m;
+    kk = 0;
+    // a[j] and a[j + 2] are processed together with a[k] and a[k - 2]
+    for (j = 2; j + 2 < m; j += 4) {
+        k = n - j;
+        kk += ks;
+        wkr = 0.5f - c[nc - kk];
+        wki = c[kk];
+        kk += ks;
+        wkr2 = 0.5f - c[nc - kk];
+        wki2 = c[kk];
+        xj = simdLoad(a + j);
+        xk = simdSwapComplex(simdLoad(a + k - 2));
+        y = simdCMul(simdSub(xj, simdNegIm(xk)), simdSet(wkr, wkr, wkr2, wkr2), simdSet(-wki, -wki, -wki2, -wki2));
+        simdStore(a + j, simdNegIm(simdSub(xj, y)));
+        simdStore(a + k - 2, simdSwapComplex(simdAdd(simdNegIm(xk), y)));
+    }
+    for (; j < m; j += 2) {
+        k = n - j;
+        kk += ks;
+        wkr = 0.5f - c[nc - kk];
+        wki = c[kk];
+        xr = a[j] - a[k];
+        xi = a[j + 1] + a[k + 1];
+        yr = wkr * xr + wki * xi;
+        yi = wkr * xi - wki * xr;
+        a[j] -= yr;
+        a[j + 1] = yi - a[j + 1];
+        a[k] += yr;
+        a[k + 1] = yi - a[k + 1];
+    }
+    a[m + 1] = -a[m + 1];
+}
+
+#endif
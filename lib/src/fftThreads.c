@@ -0,0 +1,158 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+#include <stdlib.h>
+#include "fft4g.h"
+#include "fftThreads.h"
+
+#ifdef FFT_THREADS
+
+#include <pthread.h>
+#ifdef __EMSCRIPTEN__
+#include <emscripten/threading.h>
+#else
+#include <unistd.h>
+#endif
+
+// Workers sleep until the generation changes, then run the current task with their
+// own index, and the last one to finish wakes the caller up
+static pthread_t workers[FFTMaximumThreadCount - 1];
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t startCondition = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t doneCondition = PTHREAD_COND_INITIALIZER;
+static int threadCount = 1, generation, pending, quitting;
+static FFTThreadsTask currentTask;
+static void* currentContext;
+
+static void* fftThreadsWorker(void* arg) {
+	const int index = (int)(size_t)arg;
+	// Workers are only created while there are no tasks running, and generation is
+	// reset before that (see fftSetThreadCount())
+	int lastGeneration = 0;
+	pthread_mutex_lock(&mutex);
+	for (;;) {
+		while (generation == lastGeneration && !quitting)
+			pthread_cond_wait(&startCondition, &mutex);
+		if (quitting)
+			break;
+		lastGeneration = generation;
+		const FFTThreadsTask task = currentTask;
+		void* const context = currentContext;
+		const int count = threadCount;
+		pthread_mutex_unlock(&mutex);
+		task(context, index, count);
+		pthread_mutex_lock(&mutex);
+		if (!--pending)
+			pthread_cond_signal(&doneCondition);
+	}
+	pthread_mutex_unlock(&mutex);
+	return 0;
+}
+
+// More threads than cores would only make the transforms slower (see fft4g.h)
+static int fftThreadsCoreCount(void) {
+#ifdef __EMSCRIPTEN__
+	const int coreCount = emscripten_num_logical_cores();
+#else
+	const int coreCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return ((coreCount < 1) ? 1 : coreCount);
+}
+
+int fftSetThreadCount(int newThreadCount) {
+	const int coreCount = fftThreadsCoreCount();
+	if (newThreadCount > coreCount)
+		newThreadCount = coreCount;
+	if (newThreadCount < 1)
+		newThreadCount = 1;
+	else if (newThreadCount > FFTMaximumThreadCount)
+		newThreadCount = FFTMaximumThreadCount;
+	if (newThreadCount == threadCount)
+		return threadCount;
+
+	if (threadCount > 1) {
+		pthread_mutex_lock(&mutex);
+		quitting = 1;
+		pthread_cond_broadcast(&startCondition);
+		pthread_mutex_unlock(&mutex);
+		for (int i = 0; i < threadCount - 1; i++)
+			pthread_join(workers[i], 0);
+		quitting = 0;
+	}
+
+	generation = 0;
+	threadCount = 1;
+	// If the platform refuses to create all threads, go on with those already created
+	// (in the browser, only the threads preallocated by PTHREAD_POOL_SIZE are
+	// guaranteed to start right away)
+	for (int i = 1; i < newThreadCount; i++) {
+		if (pthread_create(&workers[i - 1], 0, fftThreadsWorker, (void*)(size_t)i))
+			break;
+		threadCount++;
+	}
+	return threadCount;
+}
+
+int fftThreadsCount(void) {
+	return threadCount;
+}
+
+void fftThreadsRun(FFTThreadsTask task, void* context) {
+	const int count = threadCount;
+	if (count > 1) {
+		pthread_mutex_lock(&mutex);
+		currentTask = task;
+		currentContext = context;
+		pending = count - 1;
+		generation++;
+		pthread_cond_broadcast(&startCondition);
+		pthread_mutex_unlock(&mutex);
+	}
+	task(context, 0, count);
+	if (count > 1) {
+		pthread_mutex_lock(&mutex);
+		while (pending)
+			pthread_cond_wait(&doneCondition, &mutex);
+		pthread_mutex_unlock(&mutex);
+	}
+}
+
+#else
+
+int fftSetThreadCount(int newThreadCount) {
+	(void)newThreadCount;
+	return 1;
+}
+
+int fftThreadsCount(void) {
+	return 1;
+}
+
+void fftThreadsRun(FFTThreadsTask task, void* context) {
+	task(context, 0, 1);
+}
+
+#endif
@@ -0,0 +1,39 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+// Minimal pool used to split the large transforms among several threads (see
+// fftSetThreadCount() in fft4g.h). Tasks are called as task(context, index, count),
+// for index = 0...count-1, all at the same time (index 0 is run by the caller, who
+// only returns after all the others have finished). Only a single thread may run
+// tasks at a time (the FFT routines are not reentrant anyway, as their tables are
+// shared by all instances).
+//
+// Without FFT_THREADS, there is only one thread, and tasks are just called directly.
+
+typedef void (*FFTThreadsTask)(void* context, int index, int count);
+
+extern int fftThreadsCount(void);
+extern void fftThreadsRun(FFTThreadsTask task, void* context);
@@ -0,0 +1,284 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+#include "fft4g.h"
+#include "simd.h"
+
+// Radix-2 decimation-in-frequency transform, computed in place, from the stage with
+// blocks of n points down to the stage with blocks of 2 points, which leaves Z[k] at
+// data[bitReverse(k)] (this saves the bit reversal pass, as fftPairMagnitudesq15()
+// has to visit k and n - k anyway). Before each stage, the values are halved if they
+// could overflow (block floating-point).
+//
+// The twiddle factors e^(i.2.pi.j/m), j = 0...(m/2)-1, used by the stage with blocks of
+// m points are stored in groups of 4, as two SIMD vectors: { wr0, wr0, ..., wr3, wr3 }
+// and { -wi0, wi0, ..., -wi3, wi3 }, in Q15 (32767 = 1.0). Stages with less than 4
+// twiddle factors repeat them (j mod (m/2)), as their SIMD version processes several
+// blocks at once.
+#define FFTQ15MinimumLength 16
+#define FFTQ15MaximumLength 65536
+// The values are halved when the modulus of the next stage's output could go beyond
+// this (the components may never go beyond 32767, but any rotation could turn a
+// value's modulus into one of its components, and rounding may add up to 1 to each
+// component)
+#define FFTQ15MaximumModulus 32000
+
+static int fftStageTableLengthq15(int m) {
+	return ((((m >> 1) + 3) >> 2) << 4);
+}
+
+static int fftTableLengthq15(int n) {
+	int length = 0;
+	for (int m = n; m >= 2; m >>= 1)
+		length += fftStageTableLengthq15(m);
+	return length;
+}
+
+static unsigned short* fftBitReverseq15(const FFTQ15* fftq15) {
+	return (unsigned short*)(fftq15->table + fftTableLengthq15(fftq15->n));
+}
+
+size_t fftSizeOfq15(int n) {
+	return sizeof(FFTQ15) + (sizeof(short) * (fftTableLengthq15(n) + n));
+}
+
+FFTQ15* fftInitq15(FFTQ15* fftq15, int n) {
+	if (n < FFTQ15MinimumLength || n > FFTQ15MaximumLength || (n & (n - 1)))
+		return 0;
+	fftq15->n = n;
+
+	short* table = fftq15->table;
+	for (int m = n; m >= 2; m >>= 1) {
+		const int h = m >> 1;
+		const double _2_PI_M = (2.0 * 3.1415926535897932384626433832795) / (double)m;
+		const int count = fftStageTableLengthq15(m) >> 2;
+		for (int j = 0; j < count; j++) {
+			const short wr = (short)floor((32767.0 * cos(_2_PI_M * (double)(j & (h - 1)))) + 0.5);
+			const short wi = (short)floor((32767.0 * sin(_2_PI_M * (double)(j & (h - 1)))) + 0.5);
+			short* const w = table + ((j >> 2) << 4) + ((j & 3) << 1);
+			w[0] = wr;
+			w[1] = wr;
+			w[8] = -wi;
+			w[9] = wi;
+		}
+		table += fftStageTableLengthq15(m);
+	}
+
+	unsigned short* const bitReverse = (unsigned short*)table;
+	int log2n = 0;
+	while ((1 << log2n) < n)
+		log2n++;
+	for (int k = 0; k < n; k++) {
+		int r = 0;
+		for (int b = 0; b < log2n; b++)
+			r |= ((k >> b) & 1) << (log2n - 1 - b);
+		bitReverse[k] = (unsigned short)r;
+	}
+	return fftq15;
+}
+
+FFTQ15* fftAllocq15(int n) {
+	if (n < FFTQ15MinimumLength || n > FFTQ15MaximumLength || (n & (n - 1)))
+		return 0;
+	FFTQ15* const fftq15 = (FFTQ15*)malloc(fftSizeOfq15(n));
+	if (fftq15 && !fftInitq15(fftq15, n)) {
+		free(fftq15);
+		return 0;
+	}
+	return fftq15;
+}
+
+void fftFreeq15(FFTQ15* fftq15) {
+	if (fftq15)
+		free(fftq15);
+}
+
+// (a * b + 0x4000) >> 15, just like simdq15MulR()
+#define fftMulRq15(a, b) ((((a) * (b)) + 16384) >> 15)
+
+#ifdef FFT_SIMD_Q15
+static inline void fftButterflyq15(int halve, simdq15 va, simdq15 vb, const short* w, simdq15* sum, simdq15* diff, simdq15* vmax, simdq15* vmin) {
+	if (halve) {
+		*sum = simdq15HalfAdd(va, vb);
+		*diff = simdq15HalfSub(va, vb);
+	} else {
+		*sum = simdq15Add(va, vb);
+		*diff = simdq15Sub(va, vb);
+	}
+	*diff = simdq15CMul(*diff, simdq15Load(w), simdq15Load(w + 8));
+	*vmax = simdq15Max(*vmax, simdq15Max(*sum, *diff));
+	*vmin = simdq15Min(*vmin, simdq15Min(*sum, *diff));
+}
+#else
+static inline int fftStageScalarq15(int n, int m, int halve, int pruned, short* data, const short* w) {
+	const int h = m >> 1;
+	int max = 0, min = 0;
+	for (int s = 0; s < (n << 1); s += (m << 1)) {
+		short* const a = data + s;
+		short* const b = a + m;
+		for (int j = 0; j < h; j++) {
+			const short* const wj = w + ((j >> 2) << 4) + ((j & 3) << 1);
+			const int ar = a[(j << 1)], ai = a[(j << 1) + 1];
+			const int br = (pruned ? 0 : b[(j << 1)]), bi = (pruned ? 0 : b[(j << 1) + 1]);
+			int sr, si, dr, di;
+			if (halve) {
+				sr = (ar + br + 1) >> 1;
+				si = (ai + bi + 1) >> 1;
+				dr = (ar - br) >> 1;
+				di = (ai - bi) >> 1;
+			} else {
+				sr = ar + br;
+				si = ai + bi;
+				dr = ar - br;
+				di = ai - bi;
+			}
+			// Same roundings performed by simdq15CMul()
+			const int tr = fftMulRq15(dr, wj[0]) + fftMulRq15(di, wj[8]);
+			const int ti = fftMulRq15(di, wj[1]) + fftMulRq15(dr, wj[9]);
+			a[(j << 1)] = (short)sr;
+			a[(j << 1) + 1] = (short)si;
+			b[(j << 1)] = (short)tr;
+			b[(j << 1) + 1] = (short)ti;
+			if (max < sr) max = sr;
+			if (min > sr) min = sr;
+			if (max < si) max = si;
+			if (min > si) min = si;
+			if (max < tr) max = tr;
+			if (min > tr) min = tr;
+			if (max < ti) max = ti;
+			if (min > ti) min = ti;
+		}
+	}
+	return ((max > -min) ? max : -min);
+}
+#endif
+
+// When pruned is not 0, the second half of every block is assumed to be zero (only
+// valid for the first stage). Returns the largest absolute value of all components.
+static int fftStageq15(int n, int m, int halve, int pruned, short* data, const short* w) {
+#ifdef FFT_SIMD_Q15
+	const int h = m >> 1;
+	int peak = 0;
+	simdq15 vmax = simdq15Set1(0), vmin = simdq15Set1(0), sum, diff;
+	if (h >= 4) {
+		for (int s = 0; s < (n << 1); s += (m << 1)) {
+			short* const a = data + s;
+			short* const b = a + m;
+			for (int j = 0; j < m; j += 8) {
+				fftButterflyq15(halve, simdq15Load(a + j), (pruned ? simdq15Set1(0) : simdq15Load(b + j)), w + (j << 1), &sum, &diff, &vmax, &vmin);
+				simdq15Store(a + j, sum);
+				simdq15Store(b + j, diff);
+			}
+		}
+	} else if (h == 2) {
+		// Two blocks of 4 points at a time: { a0, a1, b0, b1 } and { a2, a3, b2, b3 }
+		for (int s = 0; s < (n << 1); s += 16) {
+			const simdq15 v0 = simdq15Load(data + s), v1 = simdq15Load(data + s + 8);
+			fftButterflyq15(halve, simdq15InterleavePairsLo(v0, v1), simdq15InterleavePairsHi(v0, v1), w, &sum, &diff, &vmax, &vmin);
+			simdq15Store(data + s, simdq15InterleavePairsLo(sum, diff));
+			simdq15Store(data + s + 8, simdq15InterleavePairsHi(sum, diff));
+		}
+	} else {
+		// Four blocks of 2 points at a time: { a0, b0, c0, d0 } and { a1, b1, c1, d1 }
+		for (int s = 0; s < (n << 1); s += 16) {
+			const simdq15 v0 = simdq15Load(data + s), v1 = simdq15Load(data + s + 8);
+			fftButterflyq15(halve, simdq15Even(v0, v1), simdq15Odd(v0, v1), w, &sum, &diff, &vmax, &vmin);
+			simdq15Store(data + s, simdq15InterleaveLo(sum, diff));
+			simdq15Store(data + s + 8, simdq15InterleaveHi(sum, diff));
+		}
+	}
+	short lanes[16];
+	simdq15Store(lanes, vmax);
+	simdq15Store(lanes + 8, vmin);
+	for (int i = 0; i < 8; i++) {
+		if (peak < lanes[i])
+			peak = lanes[i];
+		if (peak < -lanes[i + 8])
+			peak = -lanes[i + 8];
+	}
+	return peak;
+#else
+	// Each combination gets its own copy of the loop (halve and pruned are constants)
+	if (pruned)
+		return (halve ? fftStageScalarq15(n, m, 1, 1, data, w) : fftStageScalarq15(n, m, 0, 1, data, w));
+	return (halve ? fftStageScalarq15(n, m, 1, 0, data, w) : fftStageScalarq15(n, m, 0, 0, data, w));
+#endif
+}
+
+// Upper bound of the modulus of complex values whose components lie within +-peak
+static int fftModulusBoundq15(int peak, int bound) {
+	// 46341 = ceil(sqrt(2) * 32768)
+	const int modulus = ((peak * 46341) >> 15) + 1;
+	return ((modulus < bound) ? modulus : bound);
+}
+
+int fftPairPrunedq15(const FFTQ15* fftq15, short* data) {
+	const int n = fftq15->n;
+	int peak = 0;
+	for (int i = 0; i < n; i++) {
+		const int p = abs(data[i]);
+		if (peak < p)
+			peak = p;
+	}
+
+	int bound = fftModulusBoundq15(peak, 65536), exponent = 0;
+	const short* w = fftq15->table;
+	for (int m = n; m >= 2; m >>= 1) {
+		// The first stage only rotates the values, as the second half of data is zero,
+		// but the others may double their modulus
+		const int pruned = (m == n);
+		const int growth = (pruned ? bound : (bound << 1));
+		const int halve = (growth > FFTQ15MaximumModulus);
+		if (halve)
+			exponent++;
+		peak = fftStageq15(n, m, halve, pruned, data, w);
+		bound = fftModulusBoundq15(peak, (halve ? (growth >> 1) : growth) + 2);
+		w += fftStageTableLengthq15(m);
+	}
+	return exponent;
+}
+
+void fftPairMagnitudesq15(const FFTQ15* fftq15, const short* data, int exponent, float* x, float* y, int binCount) {
+	const int n = fftq15->n;
+	const unsigned short* const bitReverse = fftBitReverseq15(fftq15);
+	// X[k] = (Z[k] + conj(Z[n - k])) / 2
+	// Y[k] = (Z[k] - conj(Z[n - k])) / 2i
+	const float scale = ldexpf(0.5f, exponent);
+	for (int k = 0; k < binCount; k++) {
+		const short* const zk = data + (bitReverse[k] << 1);
+		const short* const znk = data + (bitReverse[(n - k) & (n - 1)] << 1);
+		const float xr = (float)((int)zk[0] + (int)znk[0]), xi = (float)((int)zk[1] - (int)znk[1]);
+		const float yr = (float)((int)zk[1] + (int)znk[1]), yi = (float)((int)znk[0] - (int)zk[0]);
+		x[k] = scale * sqrtf((xr * xr) + (xi * xi));
+		y[k] = scale * sqrtf((yr * yr) + (yi * yi));
+	}
+}
@@ -24,27 +24,86 @@
 // https://github.com/carlosrafaelgn/GraphicalFilterEditor
 //
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#endif
 #include <stdlib.h>
 #include <memory.h>
 #include <math.h>
 #include "fft4g.h"
+#include "simd.h"
 
-void plainAnalyzer(FFT4gf* fft4gf, const float* window, const unsigned char* data, float* tmp) {
-	for (int i = 0; i < 1024; i++)
-		tmp[i] = window[i] * (float)(((int)data[i]) - 128);
+// The window is stored in Q15 (32767 = 1.0), and the original C++ code was meant to be
+// used with 16 bit samples, which is why the 8 bit samples used to be multiplied by 4
+// (along with the window)
 
-	memset(tmp + 1024, 0, 1024 * sizeof(float));
+#ifdef FFT_SIMD_Q15
 
-	fftf(fft4gf, tmp);
+static void computeLogMagnitudes(float* tmp, int binCount) {
+	// DC and Nyquist bins are being ignored (as well as all bins above binCount,
+	// which are never read by PlainAnalyzer.analyze())
+	// 0.0000305185095 = (4 * 256) / 32767 / (2048/2), as the samples were multiplied
+	// by 256 / 32767 instead of 4 when applying the window
+	tmp[0] = 0;
+	for (int i = 1; i < binCount; i++)
+		tmp[i] = logf((tmp[i] * 0.0000305185095f) + 0.2f);
+}
+
+void plainAnalyzer(FFT4gf* fft4gf, FFTQ15* fftq15, const short* window, const unsigned char* dataL, const unsigned char* dataR, short* frame, float* tmp, int binCount) {
+	// Both channels are transformed at once by fftPairPrunedq15(), in 16 bit lanes,
+	// which takes the samples interleaved (the second half of the frame is zero-padded,
+	// and fftPairPrunedq15() does not even read it, so there is no need to clear it).
+	// The left magnitudes are stored at tmp[0...1023] and the right ones at
+	// tmp[2048...3071]. (window[i] * sample) >> 8 always fits in 16 bits.
+	(void)fft4gf;
+	for (int i = 0; i < 1024; i++) {
+		frame[(i << 1)] = (short)((window[i] * (((int)dataL[i]) - 128)) >> 8);
+		frame[(i << 1) + 1] = (short)((window[i] * (((int)dataR[i]) - 128)) >> 8);
+	}
+
+	const int exponent = fftPairPrunedq15(fftq15, frame);
+	fftPairMagnitudesq15(fftq15, frame, exponent, tmp, tmp + 2048, binCount);
+
+	computeLogMagnitudes(tmp, binCount);
+	computeLogMagnitudes(tmp + 2048, binCount);
+}
+
+#else
 
-	// DC and Nyquist bins are being ignored
+// Without 16 bit SIMD lanes, fftPairPrunedq15() is several times slower than
+// fftPairPrunedf(), so the analyzer keeps using floats (fftq15 and frame are unused)
+
+static void computeLogMagnitudes(float* tmp, int binCount) {
+	// DC and Nyquist bins are being ignored (as well as all bins above binCount,
+	// which are never read by PlainAnalyzer.analyze())
 	tmp[0] = 0;
 	tmp[1] = 0;
-	for (int i = 2; i < 2048; i += 2) {
+	for (int i = 2; i < (binCount << 1); i += 2) {
 		// 0.0009765625 = 1 / (2048/2)
 		const float d = tmp[i] * 0.0009765625f; // re
 		const float im = tmp[i + 1] * 0.0009765625f; // im
 		tmp[i >> 1] = logf(sqrtf((d * d) + (im * im)) + 0.2f);
 	}
 }
+
+void plainAnalyzer(FFT4gf* fft4gf, FFTQ15* fftq15, const short* window, const unsigned char* dataL, const unsigned char* dataR, short* frame, float* tmp, int binCount) {
+	// Both channels are transformed at once by fftPairf(), which takes the samples
+	// interleaved, and stores the left spectrum at tmp[0...2047] and the right
+	// spectrum at tmp[2048...4095] (the second half of the frame is zero-padded,
+	// and fftPairPrunedf() does not even read it, so there is no need to clear it)
+	(void)fftq15;
+	(void)frame;
+	for (int i = 0; i < 1024; i++) {
+		// 0.00012207404 = 4 / 32767
+		const float w = (float)window[i] * 0.00012207404f;
+		tmp[(i << 1)] = w * (float)(((int)dataL[i]) - 128);
+		tmp[(i << 1) + 1] = w * (float)(((int)dataR[i]) - 128);
+	}
+
+	fftPairPrunedf(fft4gf, tmp);
+
+	computeLogMagnitudes(tmp, binCount);
+	computeLogMagnitudes(tmp + 2048, binCount);
+}
+
+#endif
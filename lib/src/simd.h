@@ -0,0 +1,183 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+// The instruction set is chosen at build time: WebAssembly SIMD128 when compiling
+// with -msimd128, SSE on x86 (the compiler emits the VEX encoded versions of the
+// very same instructions when compiling with -mavx) and none at all otherwise, in
+// which case FFT_SIMD is not defined and the original scalar code is used.
+// Defining FFT_NO_SIMD forces the scalar code even when SIMD is available.
+//
+// A simdf holds two complex numbers, stored the same way Ooura's code stores
+// them: { re0, im0, re1, im1 }. All loads/stores are unaligned.
+
+#if !defined(FFT_NO_SIMD) && defined(__wasm_simd128__)
+
+#include <wasm_simd128.h>
+
+#define FFT_SIMD
+
+typedef v128_t simdf;
+
+#define simdLoad(p) wasm_v128_load(p)
+#define simdStore(p, v) wasm_v128_store((p), (v))
+#define simdSet1(x) wasm_f32x4_splat(x)
+#define simdSet(x0, x1, x2, x3) wasm_f32x4_make((x0), (x1), (x2), (x3))
+#define simdAdd(a, b) wasm_f32x4_add((a), (b))
+#define simdSub(a, b) wasm_f32x4_sub((a), (b))
+#define simdMul(a, b) wasm_f32x4_mul((a), (b))
+#define simdXor(a, b) wasm_v128_xor((a), (b))
+// { a.re0, a.im0, b.re0, b.im0 }
+#define simdLo(a, b) wasm_i32x4_shuffle((a), (b), 0, 1, 4, 5)
+// { a.re1, a.im1, b.re1, b.im1 }
+#define simdHi(a, b) wasm_i32x4_shuffle((a), (b), 2, 3, 6, 7)
+// { im0, re0, im1, re1 }
+#define simdSwapReIm(a) wasm_i32x4_shuffle((a), (a), 1, 0, 3, 2)
+// { re1, im1, re0, im0 }
+#define simdSwapComplex(a) wasm_i32x4_shuffle((a), (a), 2, 3, 0, 1)
+
+#elif !defined(FFT_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+
+#include <xmmintrin.h>
+
+#define FFT_SIMD
+
+typedef __m128 simdf;
+
+#define simdLoad(p) _mm_loadu_ps(p)
+#define simdStore(p, v) _mm_storeu_ps((p), (v))
+#define simdSet1(x) _mm_set1_ps(x)
+#define simdSet(x0, x1, x2, x3) _mm_setr_ps((x0), (x1), (x2), (x3))
+#define simdAdd(a, b) _mm_add_ps((a), (b))
+#define simdSub(a, b) _mm_sub_ps((a), (b))
+#define simdMul(a, b) _mm_mul_ps((a), (b))
+#define simdXor(a, b) _mm_xor_ps((a), (b))
+// { a.re0, a.im0, b.re0, b.im0 }
+#define simdLo(a, b) _mm_movelh_ps((a), (b))
+// { a.re1, a.im1, b.re1, b.im1 }
+#define simdHi(a, b) _mm_movehl_ps((b), (a))
+// { im0, re0, im1, re1 }
+#define simdSwapReIm(a) _mm_shuffle_ps((a), (a), _MM_SHUFFLE(2, 3, 0, 1))
+// { re1, im1, re0, im0 }
+#define simdSwapComplex(a) _mm_shuffle_ps((a), (a), _MM_SHUFFLE(1, 0, 3, 2))
+
+#endif
+
+#ifdef FFT_SIMD
+
+// Sign masks used to negate the real/imaginary parts without multiplying
+#define simdNegRe(a) simdXor((a), simdSet(-0.0f, 0.0f, -0.0f, 0.0f))
+#define simdNegIm(a) simdXor((a), simdSet(0.0f, -0.0f, 0.0f, -0.0f))
+
+// i * a = { -im0, re0, -im1, re1 }
+#define simdMulI(a) simdNegRe(simdSwapReIm(a))
+// Complex multiplication, where wr and wi hold the real and imaginary parts of the
+// twiddle factors (either broadcast, or one pair per complex number)
+#define simdCMul(a, wr, wi) simdAdd(simdMul((a), (wr)), simdMul(simdMulI(a), (wi)))
+
+#endif
+
+// A simdq15 holds four complex numbers in Q15 fixed-point: { re0, im0, ..., re3, im3 }.
+// Only WebAssembly SIMD128 and SSSE3 have a rounding Q15 multiplication
+// (i16x8.q15mulr_sat_s and pmulhrsw, which compute (a * b + 0x4000) >> 15), so
+// FFT_SIMD_Q15 is defined separately from FFT_SIMD.
+
+#if !defined(FFT_NO_SIMD) && defined(__wasm_simd128__)
+
+#define FFT_SIMD_Q15
+
+typedef v128_t simdq15;
+
+#define simdq15Load(p) wasm_v128_load(p)
+#define simdq15Store(p, v) wasm_v128_store((p), (v))
+#define simdq15Set1(x) wasm_i16x8_splat(x)
+#define simdq15Add(a, b) wasm_i16x8_add((a), (b))
+#define simdq15Sub(a, b) wasm_i16x8_sub((a), (b))
+#define simdq15MulR(a, b) wasm_i16x8_q15mulr_sat((a), (b))
+#define simdq15Xor(a, b) wasm_v128_xor((a), (b))
+#define simdq15Not(a) wasm_v128_not(a)
+// Unsigned (a + b + 1) >> 1
+#define simdq15AvgU(a, b) wasm_u16x8_avgr((a), (b))
+#define simdq15Max(a, b) wasm_i16x8_max((a), (b))
+#define simdq15Min(a, b) wasm_i16x8_min((a), (b))
+// { im0, re0, ..., im3, re3 }
+#define simdq15SwapReIm(a) wasm_i16x8_shuffle((a), (a), 1, 0, 3, 2, 5, 4, 7, 6)
+// { a0, b0, a1, b1 } and { a2, b2, a3, b3 } (each complex number is a 32-bit lane)
+#define simdq15InterleaveLo(a, b) wasm_i32x4_shuffle((a), (b), 0, 4, 1, 5)
+#define simdq15InterleaveHi(a, b) wasm_i32x4_shuffle((a), (b), 2, 6, 3, 7)
+// { a0, a1, b0, b1 } and { a2, a3, b2, b3 }
+#define simdq15InterleavePairsLo(a, b) wasm_i64x2_shuffle((a), (b), 0, 2)
+#define simdq15InterleavePairsHi(a, b) wasm_i64x2_shuffle((a), (b), 1, 3)
+// { a0, a2, b0, b2 } and { a1, a3, b1, b3 }
+#define simdq15Even(a, b) wasm_i32x4_shuffle((a), (b), 0, 2, 4, 6)
+#define simdq15Odd(a, b) wasm_i32x4_shuffle((a), (b), 1, 3, 5, 7)
+
+#elif !defined(FFT_NO_SIMD) && defined(__SSSE3__)
+
+#include <tmmintrin.h>
+
+#define FFT_SIMD_Q15
+
+typedef __m128i simdq15;
+
+#define simdq15Load(p) _mm_loadu_si128((const __m128i*)(p))
+#define simdq15Store(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+#define simdq15Set1(x) _mm_set1_epi16(x)
+#define simdq15Add(a, b) _mm_add_epi16((a), (b))
+#define simdq15Sub(a, b) _mm_sub_epi16((a), (b))
+#define simdq15MulR(a, b) _mm_mulhrs_epi16((a), (b))
+#define simdq15Xor(a, b) _mm_xor_si128((a), (b))
+#define simdq15Not(a) _mm_xor_si128((a), _mm_set1_epi16(-1))
+// Unsigned (a + b + 1) >> 1
+#define simdq15AvgU(a, b) _mm_avg_epu16((a), (b))
+#define simdq15Max(a, b) _mm_max_epi16((a), (b))
+#define simdq15Min(a, b) _mm_min_epi16((a), (b))
+// { im0, re0, ..., im3, re3 }
+#define simdq15SwapReIm(a) _mm_shufflehi_epi16(_mm_shufflelo_epi16((a), _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1))
+// { a0, b0, a1, b1 } and { a2, b2, a3, b3 } (each complex number is a 32-bit lane)
+#define simdq15InterleaveLo(a, b) _mm_unpacklo_epi32((a), (b))
+#define simdq15InterleaveHi(a, b) _mm_unpackhi_epi32((a), (b))
+// { a0, a1, b0, b1 } and { a2, a3, b2, b3 }
+#define simdq15InterleavePairsLo(a, b) _mm_unpacklo_epi64((a), (b))
+#define simdq15InterleavePairsHi(a, b) _mm_unpackhi_epi64((a), (b))
+// { a0, a2, b0, b2 } and { a1, a3, b1, b3 }
+#define simdq15Even(a, b) _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)))
+#define simdq15Odd(a, b) _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1)))
+
+#endif
+
+#ifdef FFT_SIMD_Q15
+
+// Signed (a + b + 1) >> 1 and (a - b) >> 1, computed by the unsigned average (biasing
+// both operands by 0x8000), which never overflows
+#define simdq15Bias() simdq15Set1(-32768)
+#define simdq15HalfAdd(a, b) simdq15Xor(simdq15AvgU(simdq15Xor((a), simdq15Bias()), simdq15Xor((b), simdq15Bias())), simdq15Bias())
+#define simdq15HalfSub(a, b) simdq15HalfAdd((a), simdq15Not(b))
+
+// Complex multiplication, where wr = { wr0, wr0, ..., wr3, wr3 } and
+// wi = { -wi0, wi0, ..., -wi3, wi3 }
+#define simdq15CMul(a, wr, wi) simdq15Add(simdq15MulR((a), (wr)), simdq15MulR(simdq15SwapReIm(a), (wi)))
+
+#endif
@@ -24,7 +24,9 @@
 // https://github.com/carlosrafaelgn/GraphicalFilterEditor
 //
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#endif
 #include <stdlib.h>
 #include <memory.h>
 #include <math.h>
@@ -30,15 +30,21 @@ class PlainAnalyzer extends Analyzer {
 	private readonly _analyzerR: AnalyserNode;
 
 	private readonly _visibleFrequencies: Float64Array;
+	private readonly _binCount: number;
 
 	private readonly _ptr: number;
 	private readonly _fft4gfPtr: number;
-	private readonly _dataPtr: number;
-	private readonly _data: Uint8Array;
+	private readonly _fftq15Ptr: number;
+	private readonly _dataLPtr: number;
+	private readonly _dataL: Uint8Array;
+	private readonly _dataRPtr: number;
+	private readonly _dataR: Uint8Array;
 	private readonly _tmpPtr: number;
-	private readonly _tmp: Float32Array;
+	private readonly _tmpL: Float32Array;
+	private readonly _tmpR: Float32Array;
+	private readonly _framePtr: number;
 	private readonly _windowPtr: number;
-	private readonly _window: Float32Array;
+	private readonly _window: Int16Array;
 	private readonly _multiplierPtr: number;
 	private readonly _multiplier: Float32Array;
 	private readonly _prevLPtr: number;
@@ -60,22 +66,39 @@ class PlainAnalyzer extends Analyzer {
 
 		this._visibleFrequencies = graphicalFilterEditor.visibleFrequencies;
 
+		// analyze() never reads a bin above (lastVisibleFrequency / bw) + 1, plus one bin
+		// for each one of the last values, which lie beyond the end of visibleFrequencies
+		// (512 values vs 500 frequencies), so there is no need to compute all log-magnitudes
+		// with sample rates above 48000Hz, or so
+		const visibleFrequencies = this._visibleFrequencies;
+		this._binCount = Math.min(1024, ((visibleFrequencies[visibleFrequencies.length - 1] * 2048 / this._sampleRate) | 0) + 2 + (512 - visibleFrequencies.length));
+
 		const buffer = cLib.HEAP8.buffer as ArrayBuffer;
 
-		let ptr = cLib._allocBuffer(1024 + (2048 * 4) + (1024 * 4) + (3 * 512 * 4) + cLib._fftSizeOff(2048));
+		let ptr = cLib._allocBuffer((2 * 1024) + (2 * 2048 * 4) + (2 * 2048 * 2) + (1024 * 2) + (3 * 512 * 4) + cLib._fftSizeOff(2048) + cLib._fftSizeOfq15(2048));
 		this._ptr = ptr;
 
-		this._dataPtr = ptr;
-		this._data = new Uint8Array(buffer, ptr, 1024);
+		this._dataLPtr = ptr;
+		this._dataL = new Uint8Array(buffer, ptr, 1024);
+		ptr += 1024;
+
+		this._dataRPtr = ptr;
+		this._dataR = new Uint8Array(buffer, ptr, 1024);
 		ptr += 1024;
 
+		// Both channels are analyzed at once (the right channel goes after the left one)
 		this._tmpPtr = ptr;
-		this._tmp = new Float32Array(buffer, ptr, 2048);
-		ptr += (2048 * 4);
+		this._tmpL = new Float32Array(buffer, ptr, 2048);
+		this._tmpR = new Float32Array(buffer, ptr + (2048 * 4), 2048);
+		ptr += (2 * 2048 * 4);
+
+		// Q15 frame (only used when the library has 16 bit SIMD lanes, see plainAnalyzer.c)
+		this._framePtr = ptr;
+		ptr += (2 * 2048 * 2);
 
 		this._windowPtr = ptr;
-		this._window = new Float32Array(buffer, ptr, 1024);
-		ptr += (1024 * 4);
+		this._window = new Int16Array(buffer, ptr, 1024);
+		ptr += (1024 * 2);
 
 		this._multiplierPtr = ptr;
 		this._multiplier = new Float32Array(buffer, ptr, 512);
@@ -91,6 +114,10 @@ class PlainAnalyzer extends Analyzer {
 
 		this._fft4gfPtr = ptr;
 		cLib._fftInitf(this._fft4gfPtr, 2048);
+		ptr += cLib._fftSizeOff(2048);
+
+		this._fftq15Ptr = ptr;
+		cLib._fftInitq15(this._fftq15Ptr, 2048);
 
 		const window = this._window,
 			multiplier = this._multiplier,
@@ -100,12 +127,10 @@ class PlainAnalyzer extends Analyzer {
 			invln10 = 1 / Math.LN10;
 
 		for (let i = 0; i < 1024; i++) {
-			window[i] =
-			// Adjust coefficient (the original C++ code was
-			// meant to be used with 16 bit samples)
-			4 *
-			// Hamming window
-			(0.54 - (0.46 * cos(2 * pi * i / 1023)));
+			// Hamming window, in Q15 (the gain once applied here, because
+			// the original C++ code was meant to be used with 16 bit samples,
+			// is now applied by plainAnalyzer.c)
+			window[i] = Math.round(32767 * (0.54 - (0.46 * cos(2 * pi * i / 1023))));
 		}
 
 		for (let i = 0; i < 512; i++) {
@@ -123,7 +148,8 @@ class PlainAnalyzer extends Analyzer {
 		// results in two lines that get drawn on the canvas.
 
 		const multiplier = this._multiplier,
-			tmp = this._tmp,
+			tmpL = this._tmpL,
+			tmpR = this._tmpR,
 			ctx = this.ctx as CanvasRenderingContext2D, // ctx is null only with WebGL analyzers
 			sqrt = Math.sqrt,
 			ln = Math.log,
@@ -135,10 +161,12 @@ class PlainAnalyzer extends Analyzer {
 
 		let d = 0, im = 0, i = 0, freq = 0, ii = 0, avg = 0, avgCount = 0;
 
-		this._analyzerL.getByteTimeDomainData(this._data);
-		cLib._plainAnalyzer(this._fft4gfPtr, this._windowPtr, this._dataPtr, this._tmpPtr);
+		this._analyzerL.getByteTimeDomainData(this._dataL);
+		this._analyzerR.getByteTimeDomainData(this._dataR);
+		cLib._plainAnalyzer(this._fft4gfPtr, this._fftq15Ptr, this._windowPtr, this._dataLPtr, this._dataRPtr, this._framePtr, this._tmpPtr, this._binCount);
 
-		let dataf = this._prevL;
+		let dataf = this._prevL,
+			tmp = tmpL;
 
 		ctx.lineWidth = 1;
 		ctx.fillStyle = "#000000";
@@ -187,10 +215,8 @@ class PlainAnalyzer extends Analyzer {
 
 		// Sorry for the copy/paste :(
 
-		this._analyzerR.getByteTimeDomainData(this._data);
-		cLib._plainAnalyzer(this._fft4gfPtr, this._windowPtr, this._dataPtr, this._tmpPtr);
-
 		dataf = this._prevR;
+		tmp = tmpR;
 
 		i = 0;
 		ii = 0;
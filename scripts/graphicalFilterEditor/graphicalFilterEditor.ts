@@ -120,6 +120,7 @@ class GraphicalFilterEditor extends Filter {
 	public static readonly minimumChannelValueY = GraphicalFilterEditor.validYRangeHeight - 1;
 	public static readonly maximumFilterLength = 8192;
 	public static readonly equivalentZoneCount = 10;
+	public static readonly maximumChannelCount = 8;
 	public static readonly shelfEquivalentZoneCount = 7;
 	public static readonly shelfEquivalentZones = [0, 2, 3, 4, 6, 8, 9];
 
@@ -170,14 +171,18 @@ class GraphicalFilterEditor extends Filter {
 	}
 
 	private _editorPtr: number;
+	private _channelCount: number;
 	private _filterLength: number;
 	private _sampleRate: number;
 	private _isNormalized: boolean;
+	private _latency: number;
+	private _isSinglePrecision: boolean;
 	private _iirType: GraphicalFilterEditorIIRType;
 	private _binCount: number;
 	private _audioContext: AudioContext;
 	private _filterKernel: AudioBuffer;
 	private _convolver: ConvolverNode | null;
+	private _nativeConvolver: GraphicalFilterEditorConvolver | null;
 	private _biquadFilters: AudioNode[] | null;
 	private _biquadFilterInput: AudioNode | null;
 	private _biquadFilterOutput: AudioNode | null;
@@ -189,7 +194,8 @@ class GraphicalFilterEditor extends Filter {
 	private _biquadFilterActualPhase: Float32Array | null;
 	private _curveSnapshot: Int32Array | null;
 
-	private readonly _filterKernelBuffer: Float32Array;
+	private _filterKernelBuffer: Float32Array;
+	private _filterKernels: Float32Array;
 	public readonly iirSupported: boolean;
 	public readonly channelCurves: Int32Array[];
 	public readonly actualChannelCurve: Int32Array;
@@ -199,36 +205,56 @@ class GraphicalFilterEditor extends Filter {
 
 	public filterChangedCallback: FilterChangedCallback | null | undefined;
 
-	public constructor(filterLength: number, audioContext: AudioContext, filterChangedCallback?: FilterChangedCallback | null, _iirType?: GraphicalFilterEditorIIRType) {
+	public constructor(filterLength: number, audioContext: AudioContext, filterChangedCallback?: FilterChangedCallback | null, _iirType?: GraphicalFilterEditorIIRType, channelCount?: number) {
 		super(filterChangedCallback);
 
 		if (filterLength < 8 || (filterLength & (filterLength - 1)))
 			throw "Sorry, class available only for fft sizes that are a power of 2 >= 8! :(";
 
+		if (channelCount === undefined)
+			channelCount = 2;
+		if (channelCount < 1 || channelCount > GraphicalFilterEditor.maximumChannelCount)
+			throw "Sorry, class available only for 1 to " + GraphicalFilterEditor.maximumChannelCount + " channels! :(";
+
+		this._channelCount = channelCount;
 		this._filterLength = filterLength;
 		this._sampleRate = (audioContext.sampleRate ? audioContext.sampleRate : 44100);
 		this._isNormalized = false;
+		this._latency = -1;
+		this._isSinglePrecision = false;
 		this.iirSupported = (("createBiquadFilter" in audioContext) && ("createIIRFilter" in audioContext));
 		this._iirType = (this.iirSupported && _iirType) || GraphicalFilterEditorIIRType.None;
 		this._binCount = (filterLength >>> 1) + 1;
-		this._filterKernel = audioContext.createBuffer(2, filterLength, this._sampleRate);
+		this._filterKernel = audioContext.createBuffer(this._channelCount, filterLength, this._sampleRate);
 		this._audioContext = audioContext;
 
-		this._editorPtr = cLib._graphicalFilterEditorAlloc(this._filterLength, this._sampleRate);
+		this._editorPtr = cLib._graphicalFilterEditorAlloc(this._filterLength, this._sampleRate, this._channelCount);
+		if (!this._editorPtr)
+			throw "Sorry, there is not enough memory for this filter! :(";
+		// Zone changes (the ones made through changeZoneY()) are applied without an inverse
+		// FFT, as long as the filter is not too long (see graphicalFilterEditor.c). When
+		// there is not enough memory for the basis kernels, they are just left disabled,
+		// so that the editor does not keep trying to allocate them.
+		if (!cLib._graphicalFilterEditorChangeBasisKernelsEnabled(this._editorPtr, true))
+			cLib._graphicalFilterEditorChangeBasisKernelsEnabled(this._editorPtr, false);
 
 		const buffer = cLib.HEAP8.buffer as ArrayBuffer;
 
-		this._filterKernelBuffer = new Float32Array(buffer, cLib._graphicalFilterEditorGetFilterKernelBuffer(this._editorPtr), GraphicalFilterEditor.maximumFilterLength);
-		this.channelCurves = [
-			new Int32Array(buffer, cLib._graphicalFilterEditorGetChannelCurve(this._editorPtr, 0), GraphicalFilterEditor.visibleBinCount),
-			new Int32Array(buffer, cLib._graphicalFilterEditorGetChannelCurve(this._editorPtr, 1), GraphicalFilterEditor.visibleBinCount)
-		];
+		// The kernel buffer is sized according to the filter length, and it moves whenever
+		// the length changes (see changeFilterLength())
+		this._filterKernelBuffer = new Float32Array(buffer, cLib._graphicalFilterEditorGetFilterKernelBuffer(this._editorPtr), filterLength);
+		// The kernels of all channels, one after the other (see updateFilters())
+		this._filterKernels = new Float32Array(buffer, cLib._graphicalFilterEditorGetFilterKernels(this._editorPtr), filterLength * channelCount);
+		this.channelCurves = new Array(channelCount);
+		for (let i = 0; i < channelCount; i++)
+			this.channelCurves[i] = new Int32Array(buffer, cLib._graphicalFilterEditorGetChannelCurve(this._editorPtr, i), GraphicalFilterEditor.visibleBinCount);
 		this.actualChannelCurve = new Int32Array(buffer, cLib._graphicalFilterEditorGetActualChannelCurve(this._editorPtr), GraphicalFilterEditor.visibleBinCount);
 		this.visibleFrequencies = new Float64Array(buffer, cLib._graphicalFilterEditorGetVisibleFrequencies(this._editorPtr), GraphicalFilterEditor.visibleBinCount);
 		this.equivalentZones = new Int32Array(buffer, cLib._graphicalFilterEditorGetEquivalentZones(this._editorPtr), GraphicalFilterEditor.equivalentZoneCount);
 		this.equivalentZonesFrequencyCount = new Int32Array(buffer, cLib._graphicalFilterEditorGetEquivalentZonesFrequencyCount(this._editorPtr), GraphicalFilterEditor.equivalentZoneCount + 1);
 
 		this._convolver = null;
+		this._nativeConvolver = null;
 		this._biquadFilters = null;
 		this._biquadFilterInput = null;
 		this._biquadFilterOutput = null;
@@ -240,8 +266,7 @@ class GraphicalFilterEditor extends Filter {
 		this._biquadFilterActualPhase = null;
 		this._curveSnapshot = null;
 
-		this.updateFilter(0, true, true);
-		this.updateActualChannelCurve(0);
+		this.updateFilter(0, true, true, true);
 		this.updateBuffer();
 
 		this.filterChangedCallback = filterChangedCallback;
@@ -251,10 +276,32 @@ class GraphicalFilterEditor extends Filter {
 		return this._sampleRate;
 	}
 
+	public get channelCount(): number {
+		return this._channelCount;
+	}
+
+	// Above 2 channels, there is no convolver (see updateBuffer()), and the kernels must be
+	// taken from here
+	public get filterKernel(): AudioBuffer {
+		return this._filterKernel;
+	}
+
+	public get nativeConvolver(): GraphicalFilterEditorConvolver | null {
+		return this._nativeConvolver;
+	}
+
 	public get isNormalized(): boolean {
 		return this._isNormalized;
 	}
 
+	public get latency(): number {
+		return this._latency;
+	}
+
+	public get isSinglePrecision(): boolean {
+		return this._isSinglePrecision;
+	}
+
 	public get iirType(): GraphicalFilterEditorIIRType {
 		return this._iirType;
 	}
@@ -455,6 +502,16 @@ class GraphicalFilterEditor extends Filter {
 	}
 
 	private updateBuffer(): void {
+		// A ConvolverNode only takes buffers with 1 or 2 channels (4 channels mean a true
+		// stereo matrix, not 4 independent channels), so, above 2 channels, the caller is
+		// responsible for applying filterKernel (using one mono convolver per channel,
+		// for example), and it is notified every time the kernels change
+		if (this._channelCount > 2) {
+			if (this.filterChangedCallback)
+				this.filterChangedCallback();
+			return;
+		}
+
 		const oldConvolver = this._convolver;
 		if (!this._convolver) {
 			this._convolver = this._audioContext.createConvolver();
@@ -506,30 +563,89 @@ class GraphicalFilterEditor extends Filter {
 		this.updateBuffer();
 	}
 
-	public updateFilter(channelIndex: number, isSameFilterLR: boolean, updateBothChannels: boolean): void {
+	public updateFilter(channelIndex: number, isSameFilterLR: boolean, updateBothChannels: boolean, updateActualChannelCurve?: boolean): void {
 		switch (this._iirType) {
 			case GraphicalFilterEditorIIRType.Peaking:
 				this.updatePeakingEq(channelIndex);
+				if (updateActualChannelCurve)
+					this.updateActualChannelCurveIIR();
 				return;
 			case GraphicalFilterEditorIIRType.Shelf:
 				this.updateShelfEq(channelIndex);
+				if (updateActualChannelCurve)
+					this.updateActualChannelCurveIIR();
 				return;
 		}
 
-		cLib._graphicalFilterEditorUpdateFilter(this._editorPtr, channelIndex, this._isNormalized);
+		// Computing the actual curve along with the filter is cheaper than calling
+		// updateActualChannelCurve() afterwards
+		if (updateActualChannelCurve)
+			cLib._graphicalFilterEditorUpdateFilterAndCurve(this._editorPtr, channelIndex, this._isNormalized, this._latency);
+		else
+			cLib._graphicalFilterEditorUpdateFilter(this._editorPtr, channelIndex, this._isNormalized, this._latency);
 		this.copyToChannel(this._filterKernelBuffer, channelIndex);
+		this.updateNativeConvolver(channelIndex);
 
 		if (isSameFilterLR) {
-			// Copy the filter to the other channel
-			this.copyFilter(channelIndex, 1 - channelIndex);
+			// Copy the filter to the other channels
+			for (let i = this._channelCount - 1; i >= 0; i--) {
+				if (i !== channelIndex) {
+					this.copyToChannel(this._filterKernelBuffer, i);
+					this.updateNativeConvolver(i);
+				}
+			}
+			this.updateBuffer();
 		} else if (updateBothChannels) {
-			// Update the other channel as well
-			this.updateFilter(1 - channelIndex, false, false);
+			// Update the other channels as well
+			this.updateFilters(((1 << this._channelCount) - 1) & ~(1 << channelIndex));
 		} else {
 			this.updateBuffer();
 		}
 	}
 
+	// Updates the filters of all channels in channelMask (bit i = channel i) at once, skipping
+	// the ones whose curves have not changed since the last time they were updated here
+	// (see graphicalFilterEditorUpdateFilters() in graphicalFilterEditor.c). Only FIR filters
+	// are handled, as the IIR filters are driven by a single curve (see updatePeakingEq()).
+	public updateFilters(channelMask: number): void {
+		if (this._iirType)
+			return;
+
+		cLib._graphicalFilterEditorUpdateFilters(this._editorPtr, channelMask, this._isNormalized, this._latency);
+
+		// Even the channels that were skipped are copied, as their AudioBuffer channels might
+		// have been overwritten by updateFilter()
+		const filterLength = this._filterLength,
+			nativeConvolver = this._nativeConvolver;
+		for (let i = 0; i < this._channelCount; i++) {
+			if ((channelMask & (1 << i))) {
+				this.copyToChannel(this._filterKernels.subarray(i * filterLength, (i + 1) * filterLength), i);
+				if (nativeConvolver && i < nativeConvolver.channelCount)
+					cLib._convolverChangeKernel(nativeConvolver.convolverPtr, i, this._filterKernels.byteOffset + ((i * filterLength) << 2), filterLength);
+			}
+		}
+		this.updateBuffer();
+	}
+
+	// Hands the kernel in filterKernelBuffer over to the native convolver, if any, which
+	// splits it into partitions and transforms them without the kernel leaving the heap
+	// (see graphicalFilterEditorUpdateConvolver() in graphicalFilterEditor.c)
+	private updateNativeConvolver(channelIndex: number): void {
+		const nativeConvolver = this._nativeConvolver;
+		if (nativeConvolver && channelIndex < nativeConvolver.channelCount)
+			cLib._graphicalFilterEditorUpdateConvolver(this._editorPtr, nativeConvolver.convolverPtr, channelIndex);
+	}
+
+	// The native convolver (see graphicalFilterEditorConvolver.ts) receives the FIR kernels
+	// of its channels whenever they are designed (it belongs to the caller, who must detach
+	// it, by passing null, before destroying it). It is not connected to any AudioNode, so
+	// the FIR filter keeps going through a ConvolverNode as usual.
+	public changeNativeConvolver(nativeConvolver: GraphicalFilterEditorConvolver | null): void {
+		this._nativeConvolver = nativeConvolver;
+		if (nativeConvolver && !this._iirType)
+			this.updateFilters((1 << this._channelCount) - 1);
+	}
+
 	public updateActualChannelCurve(channelIndex: number): void {
 		if (this._iirType) {
 			this.updateActualChannelCurveIIR();
@@ -864,10 +980,14 @@ class GraphicalFilterEditor extends Filter {
 
 	public changeFilterLength(newFilterLength: number, channelIndex: number, isSameFilterLR: boolean): boolean {
 		if (this._filterLength !== newFilterLength) {
+			// The editor keeps the previous length when there is not enough memory for the new one
+			if (!cLib._graphicalFilterEditorChangeFilterLength(this._editorPtr, newFilterLength))
+				throw "Sorry, there is not enough memory for this filter length! :(";
 			this._filterLength = newFilterLength;
 			this._binCount = (newFilterLength >>> 1) + 1;
-			this._filterKernel = this._audioContext.createBuffer(2, newFilterLength, this._sampleRate);
-			cLib._graphicalFilterEditorChangeFilterLength(this._editorPtr, newFilterLength);
+			this._filterKernel = this._audioContext.createBuffer(this._channelCount, newFilterLength, this._sampleRate);
+			this._filterKernelBuffer = new Float32Array(cLib.HEAP8.buffer as ArrayBuffer, cLib._graphicalFilterEditorGetFilterKernelBuffer(this._editorPtr), newFilterLength);
+			this._filterKernels = new Float32Array(cLib.HEAP8.buffer as ArrayBuffer, cLib._graphicalFilterEditorGetFilterKernels(this._editorPtr), newFilterLength * this._channelCount);
 			this.updateFilter(channelIndex, isSameFilterLR, true);
 			return true;
 		}
@@ -877,7 +997,8 @@ class GraphicalFilterEditor extends Filter {
 	public changeSampleRate(newSampleRate: number, channelIndex: number, isSameFilterLR: boolean): boolean {
 		if (this._sampleRate !== newSampleRate) {
 			this._sampleRate = newSampleRate;
-			this._filterKernel = this._audioContext.createBuffer(2, this._filterLength, newSampleRate);
+			this._filterKernel = this._audioContext.createBuffer(this._channelCount, this._filterLength, newSampleRate);
+			cLib._graphicalFilterEditorChangeSampleRate(this._editorPtr, newSampleRate);
 			this.updateFilter(channelIndex, isSameFilterLR, true);
 			return true;
 		}
@@ -893,6 +1014,35 @@ class GraphicalFilterEditor extends Filter {
 		return false;
 	}
 
+	public changeLatency(latency: number, channelIndex: number, isSameFilterLR: boolean): boolean {
+		// -1 produces linear phase kernels (filterLength / 4 samples of latency), 0 produces
+		// minimum phase kernels, and anything in between blends both (latencies longer than
+		// filterLength / 4 also produce linear phase kernels, see resolveLatency() in
+		// graphicalFilterEditor.c)
+		latency = ((latency < 0) ? -1 : (latency | 0));
+		if (this._latency !== latency) {
+			this._latency = latency;
+			this.updateFilter(channelIndex, isSameFilterLR, true);
+			return true;
+		}
+		return false;
+	}
+
+	public changeIsSinglePrecision(isSinglePrecision: boolean, channelIndex: number, isSameFilterLR: boolean): boolean {
+		// The filter is designed in floats instead of doubles (faster, but slightly less
+		// accurate, see updateFilterf() in graphicalFilterEditor.c)
+		if (!this._isSinglePrecision !== !isSinglePrecision) {
+			// The editor keeps the previous precision when there is not enough memory for the
+			// single precision FFT
+			if (!cLib._graphicalFilterEditorChangeIsSinglePrecision(this._editorPtr, !!isSinglePrecision))
+				throw "Sorry, there is not enough memory for this precision! :(";
+			this._isSinglePrecision = !!isSinglePrecision;
+			this.updateFilter(channelIndex, isSameFilterLR, true);
+			return true;
+		}
+		return false;
+	}
+
 	public changeIIRType(iirType: GraphicalFilterEditorIIRType, channelIndex: number, isSameFilterLR: boolean): boolean {
 		if (this._iirType !== iirType && this.iirSupported) {
 			this._iirType = iirType;
@@ -942,7 +1092,8 @@ class GraphicalFilterEditor extends Filter {
 			this._biquadFilterActualPhase = null;
 			this._audioContext = newAudioContext;
 			this._sampleRate = (newAudioContext.sampleRate ? newAudioContext.sampleRate : 44100);
-			this._filterKernel = newAudioContext.createBuffer(2, this._filterLength, this._sampleRate);
+			this._filterKernel = newAudioContext.createBuffer(this._channelCount, this._filterLength, this._sampleRate);
+			cLib._graphicalFilterEditorChangeSampleRate(this._editorPtr, this._sampleRate);
 			this.updateFilter(channelIndex, isSameFilterLR, true);
 			this.updateBuffer();
 			return true;
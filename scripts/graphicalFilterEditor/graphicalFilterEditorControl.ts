@@ -393,13 +393,13 @@ class GraphicalFilterEditorControl {
 
 		const isNormalized = ((settings.isNormalized === false || settings.isNormalized === true) ? settings.isNormalized : filter.isNormalized);
 
-		if (isNormalized === filter.isNormalized)
-			filter.updateFilter(this._currentChannelIndex, this.isSameFilterLR, true);
-		else
+		if (isNormalized === filter.isNormalized) {
+			filter.updateFilter(this._currentChannelIndex, this.isSameFilterLR, true, this._isActualChannelCurveNeeded);
+		} else {
 			filter.changeIsNormalized(isNormalized, this._currentChannelIndex, this.isSameFilterLR);
-
-		if (this._isActualChannelCurveNeeded)
-			this.filter.updateActualChannelCurve(this._currentChannelIndex);
+			if (this._isActualChannelCurveNeeded)
+				this.filter.updateActualChannelCurve(this._currentChannelIndex);
+		}
 
 		this.checkMenu(this.mnuShowZones, this._showZones);
 		this.editMode = this._editMode;
@@ -592,9 +592,7 @@ class GraphicalFilterEditorControl {
 			if (!this.isSameFilterLR || this._currentChannelIndex !== channelIndex) {
 				if (this.isSameFilterLR) {
 					this._currentChannelIndex = channelIndex;
-					this.filter.updateFilter(channelIndex, true, true);
-					if (this._isActualChannelCurveNeeded)
-						this.filter.updateActualChannelCurve(channelIndex);
+					this.filter.updateFilter(channelIndex, true, true, this._isActualChannelCurveNeeded);
 					this.drawCurve();
 				} else {
 					this.isSameFilterLR = true;
@@ -799,9 +797,7 @@ class GraphicalFilterEditorControl {
 		for (let i = curve.length - 1; i >= 0; i--)
 			curve[i] = GraphicalFilterEditor.zeroChannelValueY;
 
-		this.filter.updateFilter(this._currentChannelIndex, this.isSameFilterLR, false);
-		if (this._isActualChannelCurveNeeded)
-			this.filter.updateActualChannelCurve(this._currentChannelIndex);
+		this.filter.updateFilter(this._currentChannelIndex, this.isSameFilterLR, false, this._isActualChannelCurveNeeded);
 		this.drawCurve();
 	}
 
@@ -829,9 +825,7 @@ class GraphicalFilterEditorControl {
 	}
 
 	public commitChanges(): void {
-		this.filter.updateFilter(this._currentChannelIndex, this.isSameFilterLR, false);
-		if (this._isActualChannelCurveNeeded)
-			this.filter.updateActualChannelCurve(this._currentChannelIndex);
+		this.filter.updateFilter(this._currentChannelIndex, this.isSameFilterLR, false, this._isActualChannelCurveNeeded);
 		this.drawCurve();
 	}
 
@@ -0,0 +1,127 @@
+//
+// MIT License
+//
+// Copyright (c) 2012-2020 Carlos Rafael Gimenes das Neves
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://github.com/carlosrafaelgn/GraphicalFilterEditor
+//
+
+// Native partitioned convolution (see lib/src/convolver.h), which does not depend on
+// ConvolverNode, so its latency (blockSize samples) and its cost are always the same, and
+// it can also be used to filter samples offline. Long kernels are split into segments with
+// longer partitions after the first blocks (see segmentCount), which makes each block a
+// lot cheaper than with a uniform partition (though, per sample, still more expensive than
+// with a larger blockSize, see lib/src/convolver.h).
+class GraphicalFilterEditorConvolver {
+	public static readonly minimumBlockSize = 128;
+	public static readonly maximumBlockSize = 4096;
+
+	private _convolverPtr: number;
+	private readonly _blockSize: number;
+	private readonly _channelCount: number;
+	private readonly _blocks: Float32Array[];
+
+	public constructor(blockSize: number, channelCount?: number, maximumKernelLength?: number) {
+		if (blockSize < GraphicalFilterEditorConvolver.minimumBlockSize || blockSize > GraphicalFilterEditorConvolver.maximumBlockSize || (blockSize & (blockSize - 1)))
+			throw "Sorry, class available only for block sizes that are a power of 2 from " + GraphicalFilterEditorConvolver.minimumBlockSize + " to " + GraphicalFilterEditorConvolver.maximumBlockSize + "! :(";
+
+		if (channelCount === undefined)
+			channelCount = 2;
+		if (channelCount < 1 || channelCount > GraphicalFilterEditor.maximumChannelCount)
+			throw "Sorry, class available only for 1 to " + GraphicalFilterEditor.maximumChannelCount + " channels! :(";
+
+		this._blockSize = blockSize;
+		this._channelCount = channelCount;
+		this._convolverPtr = cLib._convolverAlloc(blockSize, maximumKernelLength || GraphicalFilterEditor.maximumFilterLength, channelCount);
+		if (!this._convolverPtr)
+			throw "Sorry, there is not enough memory for this convolver! :(";
+
+		const buffer = cLib.HEAP8.buffer as ArrayBuffer;
+
+		this._blocks = new Array(channelCount);
+		for (let i = 0; i < channelCount; i++)
+			this._blocks[i] = new Float32Array(buffer, cLib._convolverGetBlock(this._convolverPtr, i), blockSize);
+	}
+
+	public get convolverPtr(): number {
+		return this._convolverPtr;
+	}
+
+	public get blockSize(): number {
+		return this._blockSize;
+	}
+
+	public get channelCount(): number {
+		return this._channelCount;
+	}
+
+	public get segmentCount(): number {
+		return cLib._convolverGetSegmentCount(this._convolverPtr);
+	}
+
+	public segmentPartitionLength(segmentIndex: number): number {
+		return cLib._convolverGetSegmentPartitionLength(this._convolverPtr, segmentIndex);
+	}
+
+	public segmentPartitionCount(segmentIndex: number): number {
+		return cLib._convolverGetSegmentPartitionCount(this._convolverPtr, segmentIndex);
+	}
+
+	public destroy(): void {
+		if (this._convolverPtr) {
+			cLib._convolverFree(this._convolverPtr);
+			zeroObject(this);
+		}
+	}
+
+	public changeKernel(channelIndex: number, kernel: Float32Array): void {
+		// The kernel is copied to the heap just for a moment, as the convolver keeps only
+		// its transformed partitions (GraphicalFilterEditor.updateConvolver() skips this copy)
+		const kernelPtr = cLib._allocBuffer(kernel.length << 2);
+		(new Float32Array(cLib.HEAP8.buffer as ArrayBuffer, kernelPtr, kernel.length)).set(kernel);
+		cLib._convolverChangeKernel(this._convolverPtr, channelIndex, kernelPtr, kernel.length);
+		cLib._freeBuffer(kernelPtr);
+	}
+
+	public reset(): void {
+		cLib._convolverReset(this._convolverPtr);
+	}
+
+	// Filters the samples of every channel in place (all arrays must have the same length,
+	// which must be a multiple of blockSize)
+	public process(channels: Float32Array[]): void {
+		const blockSize = this._blockSize,
+			blocks = this._blocks,
+			channelCount = Math.min(this._channelCount, channels.length),
+			length = (channelCount ? channels[0].length : 0);
+
+		if ((length % blockSize))
+			throw "Sorry, the length must be a multiple of the block size! :(";
+
+		for (let offset = 0; offset < length; offset += blockSize) {
+			for (let i = 0; i < channelCount; i++)
+				blocks[i].set(channels[i].subarray(offset, offset + blockSize));
+			cLib._convolverProcess(this._convolverPtr);
+			for (let i = 0; i < channelCount; i++)
+				channels[i].set(blocks[i], offset);
+		}
+	}
+}